@@ -0,0 +1,103 @@
+/* Projecta clock autotune benchmark
+ * A simulated screen whose transfers fail above a clock
+ * limit, as over a long or loaded cable. Checks that
+ * autotuneClock() settles a rate below the limit on a short
+ * and a marginal cable, that a cable which degrades while
+ * running is stepped down by loop(), and that a missing
+ * screen is reported. Reports the bus time per frame at each
+ * clock. See extras/README.md.
+ */
+#include <Projecta.h>
+#include <Wire.h>
+#include <stdio.h>
+
+static SimScreen screen;
+static uint32_t failures = 0;
+
+static void check(const char* name, bool ok){
+    printf("%-44s %s\n", name, ok ? "ok" : "FAILED");
+    failures += !ok;
+}
+
+/* Runs the screen for a while with a new value every 100 ms
+ * @returns -> bad frames the screen saw
+ */
+static uint32_t run(Projecta& proj, uint32_t ms){
+    uint32_t before = screen.getChecksumErrors();
+    for(uint32_t t=0;t<ms;t+=5){
+        if(t % 100 == 0){
+            proj.setVoltage_mV(12000 + (int32_t)(millis() / 100) % 2000);
+        }
+        proj.loop();
+        hostAdvanceMicros(5000);
+    }
+    return screen.getChecksumErrors() - before;
+}
+
+/* Function to get the bus time of one frame write at a clock
+ * @returns -> microseconds
+ */
+static uint32_t frameMicros(uint32_t hz){
+    uint64_t before = Wire.getBusMicros();
+    Wire.setClock(hz);
+    Wire.beginTransmission(0x65);
+    Wire.write(screen.getFrame(), 10);
+    Wire.endTransmission();
+    return (uint32_t)(Wire.getBusMicros() - before);
+}
+
+int main(){
+    Wire.attachDevice(0x65, &screen);
+    hostUseManualClock(true);
+    Projecta proj(Wire);
+    proj.begin();
+
+    printf("bus time per frame write:");
+    const uint32_t rates[4] = {100000, 200000, 400000, 1000000};
+    for(uint8_t i=0;i<4;i++){
+        printf(" %u us at %u kHz%s", frameMicros(rates[i]), rates[i] / 1000, i < 3 ? "," : "\n");
+    }
+
+    // Short cable, good to 1 MHz: one rate in hand leaves 400 kHz
+    screen.setClockLimit(1000000, 200);
+    uint32_t bad;
+    bool ok = proj.autotuneClock() == PROJ_OK;
+    printf("short cable: %u kHz\n", proj.getBusClock() / 1000);
+    check("short cable settles at 400 kHz", ok && proj.getBusClock() == 400000 && Wire.getClock() == 400000);
+    check("short cable runs without bad frames", run(proj, 10000) == 0 && proj.getBusClock() == 400000);
+
+    // Marginal cable, unreliable above 200 kHz
+    screen.setClockLimit(200000, 50);
+    screen.resetCounters();
+    ok = proj.autotuneClock(32, 0) == PROJ_OK;
+    printf("marginal cable: %u kHz with no margin (%u glitches while tuning)\n", proj.getBusClock() / 1000,
+        screen.getGlitches());
+    check("marginal cable passes 200 kHz", ok && proj.getBusClock() == 200000);
+    ok = proj.autotuneClock() == PROJ_OK;
+    printf("marginal cable: %u kHz with one rate in hand\n", proj.getBusClock() / 1000);
+    check("marginal cable settles at 100 kHz", ok && proj.getBusClock() == 100000);
+    uint8_t frame[10];
+    bad = run(proj, 10000);
+    proj.getFrame(frame);
+    check("marginal cable runs without bad frames", bad == 0 && memcmp(screen.getFrame(), frame, 10) == 0);
+
+    // Good cable that degrades while running
+    screen.setClockLimit(1000000, 200);
+    proj.autotuneClock();
+    run(proj, 5000);
+    screen.setClockLimit(200000, 100);
+    screen.resetCounters();
+    bad = run(proj, 20000);
+    printf("degraded cable: stepped down to %u kHz, %u glitches, %u bad frames before the step\n",
+        proj.getBusClock() / 1000, screen.getGlitches(), bad);
+    check("degraded cable steps down to 200 kHz", proj.getBusClock() == 200000 && Wire.getClock() == 200000);
+    check("degraded cable then runs without bad frames", run(proj, 10000) == 0 && proj.isConnected());
+
+    // No screen at all
+    screen.setConnected(false);
+    check("missing screen reported", proj.autotuneClock() == PROJ_I2C_ERROR && Wire.getClock() == 100000 &&
+        proj.getBusClock() == 0);
+    screen.setConnected(true);
+    hostUseManualClock(false);
+    return failures ? 1 : 0;
+}
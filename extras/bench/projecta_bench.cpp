@@ -0,0 +1,356 @@
+/* Projecta host benchmark
+ * Runs the library against the simulated bus and screen
+ * and reports loop() latency, bus bytes per second and
+ * encoder throughput. See extras/README.md for building.
+ */
+#include <Projecta.h>
+#include <ProjectaEnergy.h>
+#include <ProjectaMarquee.h>
+#include <Wire.h>
+#include <stdio.h>
+#include <time.h>
+
+static volatile uint32_t sink;
+
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char* name, uint64_t ns, uint32_t iterations){
+    printf("%-34s %10.1f ns/op %12.0f op/s\n", name,
+        (double)ns / iterations, iterations * 1e9 / (double)ns);
+}
+
+/* Latency of one loop() call, with the frame changing on
+ * every call and with an unchanged frame
+ */
+static void benchLoop(Projecta& proj){
+    const uint32_t n = 200000;
+    uint64_t t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        proj.setVoltage((i % 1000) / 10.0);
+        proj.loop();
+    }
+    report("loop() changing frame", nowNs() - t, n);
+
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        proj.loop();
+    }
+    report("loop() unchanged frame", nowNs() - t, n);
+
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        sink = proj.step();
+    }
+    report("step()", nowNs() - t, n);
+}
+
+/* Bus traffic over ten simulated seconds with the
+ * application calling into the library every millisecond
+ */
+static void benchBusTraffic(Projecta& proj, SimScreen& screen, const char* name, bool useStep){
+    const uint32_t seconds = 10;
+    hostUseManualClock(true);
+    Wire.resetCounters();
+    screen.resetCounters();
+    uint32_t start = millis();
+    uint32_t i = 0;
+    while((uint32_t)(millis() - start) < seconds * 1000UL){
+        if((i++ % 500) == 0){
+            proj.setCurrent(i / 1000.0);
+        }
+        if(useStep){
+            proj.step();
+        }else{
+            proj.loop();
+        }
+        hostAdvanceMicros(1000);
+    }
+    hostUseManualClock(false);
+    printf("%-34s %10.0f B/s %8.0f trans/s %6.0f reads/s %6.1f%% bus busy\n", name,
+        (double)(Wire.getBytesWritten() + Wire.getBytesRead()) / seconds,
+        (double)Wire.getTransactions() / seconds,
+        (double)screen.getReads() / seconds,
+        Wire.getBusMicros() / (seconds * 1e4));
+}
+
+static void benchEncoders(Projecta& proj){
+    const uint32_t n = 2000000;
+    uint64_t t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        sink = proj.setVoltage((i % 10000) / 10.0);
+    }
+    report("sevenSegEncoder(double)", nowNs() - t, n);
+
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        sink = proj.setVoltage_mV((i % 10000) * 100);
+    }
+    report("sevenSegEncoderMilli(int32_t)", nowNs() - t, n);
+
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        proj.beginUpdate();
+        proj.setVoltage_mV((i % 10000) * 100);
+        proj.setBatteryType(BATTERY_AGM);
+        proj.setBatteryBar(i & 3);
+        proj.commit();
+    }
+    report("3 setters in one commit()", nowNs() - t, n);
+
+    char words[4][4] = {"abc", "Err", "uP ", "SEt"};
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        sink = proj.sevenSegEncoder(words[i & 3]);
+    }
+    report("sevenSegEncoder(char*)", nowNs() - t, n);
+
+    ProjectaMarquee marquee(proj);
+    marquee.setText("Absorb 14.4V  Float 13.6V");
+    marquee.setStepInterval(0);
+    t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        marquee.loop();
+    }
+    report("ProjectaMarquee step", nowNs() - t, n);
+}
+
+/* Integrate an 8 hour session of alternating voltage and
+ * current frames every 100 ms, as a display shows them (3
+ * digits), and compare the fixed point totals with the same
+ * integration in double
+ * @returns -> true if they agree to 1 mAh/mWh
+ */
+static bool benchEnergy(void){
+    const uint32_t n = 288000;
+    static int32_t values[n];
+    for(uint32_t i=0;i<n;i++){
+        uint32_t minute = i / 600;
+        values[i] = (i & 1) ? (int32_t)((25000 - minute * 50) / 100 * 100)   // mA, tapering
+                            : (int32_t)((12500 + minute * 5) / 10 * 10);    // mV, rising
+        if(values[i] < 0){
+            values[i] = 0;
+        }
+    }
+    double ah = 0, wh = 0, v = 0, a = 0;
+    bool haveV = false, haveA = false;
+    for(uint32_t i=0;i<n;i++){
+        if(haveV && haveA){
+            ah += a * 0.1 / 3600;
+            wh += v * a * 0.1 / 3600;
+        }
+        if(i & 1){
+            a = values[i] / 1000.0;
+            haveA = true;
+        }else{
+            v = values[i] / 1000.0;
+            haveV = true;
+        }
+    }
+    ProjectaEnergy energy;
+    uint64_t t = nowNs();
+    for(uint32_t i=0;i<n;i++){
+        energy.addSample((i & 1) ? UNIT_AMP : UNIT_VOLT, values[i], i * 100);
+    }
+    report("ProjectaEnergy sample", nowNs() - t, n);
+    double dAh = energy.getCharge_mAh() - ah * 1000, dWh = energy.getEnergy_mWh() - wh * 1000;
+    printf("energy: %u mAh (double %.1f), %u mWh (double %.1f), avg %u mA over %u s\n",
+        energy.getCharge_mAh(), ah * 1000, energy.getEnergy_mWh(), wh * 1000,
+        energy.getRange(UNIT_AMP).average, energy.getDuration() / 1000);
+    return dAh > -1 && dAh < 1 && dWh > -1 && dWh < 1;
+}
+
+/* Reference for the double setters, written the way the
+ * original encoder was: pick the decade from the value, round
+ * once to the displayed digits, and (unlike the original,
+ * which showed dashes) move the decimal point on a carry
+ * @returns -> digits, -1 if the value does not fit
+ */
+static int32_t referenceDouble(double val, uint8_t* decimals){
+    double digits;
+    if(val < 10){
+        *decimals = 2;
+        digits = round(val * 100);
+    }else if(val < 100){
+        *decimals = 1;
+        digits = round(val * 10);
+    }else{
+        *decimals = 0;
+        digits = round(val);
+    }
+    if(digits >= 1000 && *decimals){
+        (*decimals)--;
+        digits = round(*decimals ? val * 10 : val);
+    }
+    return val < 0 || digits >= 1000 ? -1 : (int32_t)digits;
+}
+
+/* Reference for the fixed point setters: decimal rounding,
+ * half up, by integer division
+ * @returns -> digits, -1 if the value does not fit
+ */
+static int32_t referenceMilli(int32_t milli, uint8_t* decimals){
+    int32_t scale = 10;
+    for(*decimals = 2; ; (*decimals)--, scale *= 10){
+        int32_t digits = (milli + scale / 2) / scale;
+        if(digits < 1000){
+            return milli < 0 ? -1 : digits;
+        }
+        if(!*decimals){
+            return -1;
+        }
+    }
+}
+
+/* Function to compare the frame on the screen with the
+ * expected digits
+ * @returns -> true if bytes 1-3 match
+ */
+static bool showsDigits(SimScreen& screen, int32_t digits, uint8_t decimals){
+    const uint8_t* frame = screen.getFrame();
+    uint8_t d = digits < 0 ? 3 : decimals;
+    uint16_t v = digits < 0 ? 0 : (uint16_t)digits;
+    for(uint8_t i=1;i<=3;i++){
+        if(frame[i] != projectaQuantisedByte(v, d, i)){
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Check both encoders against their references: the double
+ * setter over 0-999.9 in 0.1 steps, 0-9.99 in 0.01 steps,
+ * 0.001 steps around 10, 100 and 1000, and values just either
+ * side of a rounding point (x.xx49x, 9.99499...); the fixed
+ * point setter over the same grids. On the 0.1 and 0.01 grids
+ * both must also show the same frame.
+ * @returns -> number of mismatching values
+ */
+static uint32_t checkFixedPoint(Projecta& proj, SimScreen& screen){
+    const int32_t edges[3] = {10000, 100000, 1000000};
+    const double offGrid[] = {1.23496, 12.3496, 9.9949, 9.99499, 0.0049996, 99.9499, 99.94999, 999.4999,
+                              0.0049999, 0.005, 1.005, 2.675, 9.995, 99.95, 999.5};
+    const uint16_t nOff = sizeof(offGrid) / sizeof(offGrid[0]);
+    uint32_t mismatches = 0;
+    uint8_t frame[10], decimals;
+    for(int32_t k=0;k<11000 + 3 * 200 + 2 * 20000 + nOff;k++){
+        int32_t j = k - 11600;
+        double val;
+        int32_t mV = -1;
+        if(k < 11600){
+            mV = k < 10000 ? k * 100 : k < 11000 ? (k - 10000) * 10 : edges[(k - 11000) / 200] - 100 + (k - 11000) % 200;
+            val = k < 10000 ? k / 10.0 : k < 11000 ? (k - 10000) / 100.0 : mV / 1000.0;
+        }else if(j < 40000){
+            // Just below and above every half step of the 0.01 grid
+            val = (j / 2 + 0.5) / 100.0 + (j & 1 ? 1e-7 : -1e-7);
+        }else{
+            val = offGrid[j - 40000];
+        }
+        proj.setVoltage(val);
+        proj.loop();
+        memcpy(frame, screen.getFrame(), 10);
+        int32_t want = referenceDouble(val, &decimals);
+        bool ok = showsDigits(screen, want, decimals);
+        if(mV >= 0){
+            proj.setVoltage_mV(mV);
+            proj.loop();
+            want = referenceMilli(mV, &decimals);
+            ok = ok && showsDigits(screen, want, decimals);
+            ok = ok && (k >= 11000 || memcmp(frame, screen.getFrame(), 10) == 0);
+        }
+        if(!ok && mismatches++ < 5){
+            printf("encoder mismatch at %.7f\n", val);
+        }
+    }
+    return mismatches;
+}
+
+// Fixed screens built at compile time
+static const projecta_frame _errFrame PROGMEM = projectaTextFrame("Err");
+static_assert(projectaTextValid("Err"), "no glyph");
+static_assert(projectaTextFrame("---").bytes[9] == 3 * PROJ_SEG_DASH, "dash checksum");
+static_assert(projectaEncodeFrame(UNIT_VOLT, 12340).bytes[2] == (projectaDigitSegments(2) | PROJ_SEG_DP), "12.3 V");
+static_assert(projectaEncodeFrame(UNIT_WATT, 1500000).bytes[0] == PROJ_UNIT_CODE_KILOWATT, "1.50 kW");
+
+/* Check the setters leave exactly the frame projectaEncodeFrame()
+ * builds, over every unit, battery type, bar level and LED
+ * @returns -> number of mismatching frames
+ */
+static uint32_t checkCodec(Projecta& proj, SimScreen& screen){
+    static const int32_t values[] = {0, 5, 9994, 9995, 12345, 99949, 99950, 999499, 999500,
+                                     1000000, 1234567, 999499999, -1};
+    uint32_t mismatches = 0;
+    for(uint8_t unit=UNIT_NONE;unit<UNIT_UNKNOWN;unit++){
+        for(uint8_t v=0;v<sizeof(values)/sizeof(values[0]);v++){
+            uint8_t bat = (unit + v) % 6;
+            uint8_t bar = (unit + v) % 5;
+            uint8_t led = (unit * 3 + v) % 5;
+            bool buz = v & 1;
+            proj.beginUpdate();
+            proj.clearScreen();
+            proj.setValueMilli((projecta_unit)unit, values[v]);
+            proj.setBatteryType((projecta_battery_type)bat);
+            proj.setBatteryBar(bar);
+            proj.setLed((projecta_led)led, true);
+            proj.setBuzzer(buz);
+            proj.commit();
+            proj.loop();
+            projecta_frame f = projectaEncodeFrame(unit, values[v], bat, bar, projectaLedBit(led), buz);
+            if(memcmp(f.bytes, screen.getFrame(), 10) != 0 && mismatches++ < 5){
+                printf("codec mismatch at unit %u value %d\n", unit, values[v]);
+            }
+        }
+    }
+    proj.setFrame_P(&_errFrame);
+    proj.loop();
+    if(memcmp(screen.getFrame(), projectaTextFrame("Err").bytes, 10) != 0){
+        mismatches++;
+    }
+    return mismatches;
+}
+
+int main(){
+    SimScreen screen;
+    Wire.attachDevice(0x65, &screen);
+    Projecta proj;
+    if(proj.begin() != PROJ_OK){
+        printf("begin() failed\n");
+        return 1;
+    }
+
+    uint32_t mismatches = checkFixedPoint(proj, screen);
+    printf("double and fixed point encoders: %u mismatches against the references\n", mismatches);
+    if(mismatches){
+        return 1;
+    }
+    mismatches = checkCodec(proj, screen);
+    printf("frame codec: %u mismatches\n", mismatches);
+    if(mismatches){
+        return 1;
+    }
+
+    printf("-- latency --\n");
+    benchLoop(proj);
+    printf("-- bus traffic (100 kHz, 1 ms call period) --\n");
+    benchBusTraffic(proj, screen, "loop()", false);
+    benchBusTraffic(proj, screen, "step()", true);
+    screen.setButtons(BUTTON_VOLT_AMP);
+    benchBusTraffic(proj, screen, "step() button held", true);
+    screen.setButtons(0);
+    printf("-- encoders --\n");
+    benchEncoders(proj);
+    if(!benchEnergy()){
+        printf("energy totals differ from double\n");
+        return 1;
+    }
+
+    if(screen.getChecksumErrors() || screen.getLengthErrors()){
+        printf("screen rejected %u frames\n",
+            screen.getChecksumErrors() + screen.getLengthErrors());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/* Projecta fleet benchmark
+ * 40 simulated screens behind five TCA9548A muxes on one
+ * 400 kHz bus. Every screen gets a new value twice a second
+ * and one screen at a time has a button held. Reports frames
+ * and button reads per second, mux channel switches and
+ * worst update latency for ProjectaFleet and for calling
+ * each screen's loop() in an order that alternates muxes.
+ * See extras/README.md.
+ */
+#include <ProjectaDecoder.h>
+#include <ProjectaFleet.h>
+#include <Wire.h>
+#include <stdio.h>
+
+#define MUXES 5
+#define SCREENS (MUXES * 8)
+
+struct Result{
+    uint32_t frames;
+    uint32_t reads;
+    uint32_t switches;
+    uint32_t worstLatency;
+    uint32_t errors;    // collisions, rejected or misrouted frames
+    double busy;
+};
+
+static SimMux simMux[MUXES];
+static SimScreen simScreen[SCREENS];
+static Projecta* screens[SCREENS];  // screens[i] drives simScreen[i]
+
+/* Ten simulated seconds. Screen i gets a new value every
+ * 500 ms, offset by i * 12.5 ms; latency counts from the
+ * update to the frame reaching its simulated screen. Each
+ * screen must end up showing the last value it was given.
+ */
+static Result run(ProjectaFleet* fleet, Projecta** order){
+    Wire.resetCounters();
+    Result r = {0, 0, 0, 0, 0, 0};
+    for(uint8_t m=0;m<MUXES;m++){
+        simMux[m].resetCounters();
+    }
+    uint32_t received[SCREENS], updatedAt[SCREENS], nextUpdate[SCREENS];
+    int16_t value[SCREENS];
+    bool waiting[SCREENS];
+    for(uint8_t i=0;i<SCREENS;i++){
+        simScreen[i].resetCounters();
+        received[i] = 0;
+        waiting[i] = false;
+    }
+    hostUseManualClock(true);
+    uint32_t start = micros();
+    for(uint8_t i=0;i<SCREENS;i++){
+        nextUpdate[i] = start + i * 12500;
+    }
+    uint32_t n = 0;
+    while((uint32_t)(micros() - start) < 10000000UL){
+        uint32_t t = micros() - start;
+        for(uint8_t i=0;i<SCREENS;i++){
+            if((int32_t)(micros() - nextUpdate[i]) >= 0){
+                nextUpdate[i] += 500000;
+                value[i] = (int16_t)(n++ % 1000);
+                screens[i]->setVoltage_mV(value[i] * 100);
+                updatedAt[i] = micros();
+                waiting[i] = true;
+            }
+            simScreen[i].setButtons(i == (t / 1000000) % SCREENS ? BUTTON_VOLT_AMP : 0);
+        }
+        if(fleet){
+            fleet->loop();
+        }else{
+            for(uint8_t i=0;i<SCREENS;i++){
+                order[i]->loop();
+            }
+        }
+        for(uint8_t i=0;i<SCREENS;i++){
+            if(simScreen[i].getFramesReceived() != received[i]){
+                received[i] = simScreen[i].getFramesReceived();
+                if(waiting[i]){
+                    uint32_t lat = micros() - updatedAt[i];
+                    r.worstLatency = lat > r.worstLatency ? lat : r.worstLatency;
+                    waiting[i] = false;
+                }
+            }
+        }
+        hostAdvanceMicros(100);
+    }
+    // Let the last updates drain
+    for(uint8_t k=0;k<100;k++){
+        if(fleet){
+            fleet->loop();
+        }else{
+            for(uint8_t i=0;i<SCREENS;i++){
+                order[i]->loop();
+            }
+        }
+        hostAdvanceMicros(1000);
+    }
+    hostUseManualClock(false);
+    r.errors = Wire.getCollisions();
+    for(uint8_t i=0;i<SCREENS;i++){
+        projecta_telemetry tel;
+        r.frames += simScreen[i].getFramesReceived();
+        r.reads += simScreen[i].getReads();
+        r.errors += simScreen[i].getChecksumErrors() + simScreen[i].getLengthErrors();
+        if(projectaDecodeFrame(simScreen[i].getFrame(), tel) != PROJ_OK || tel.raw != value[i]){
+            r.errors++;
+        }
+    }
+    for(uint8_t m=0;m<MUXES;m++){
+        r.switches += simMux[m].getSelects();
+    }
+    r.busy = Wire.getBusMicros() / 1e5;
+    return r;
+}
+
+static void print(const char* name, const Result& r){
+    printf("%-22s %9.0f %9.0f %11.0f %10.1f %6.1f%% %7u\n", name, r.frames / 10.0, r.reads / 10.0,
+        r.switches / 10.0, r.worstLatency / 1000.0, r.busy, r.errors);
+}
+
+int main(){
+    static ProjectaMux* mux[MUXES];
+    static Projecta* interleaved[SCREENS];
+    ProjectaFleet fleet;
+    Wire.setClock(400000);
+    for(uint8_t m=0;m<MUXES;m++){
+        Wire.attachDevice(0x70 + m, &simMux[m]);
+        mux[m] = new ProjectaMux(Wire, 0x70 + m);
+    }
+    for(uint8_t i=0;i<SCREENS;i++){
+        simMux[i / 8].attachDevice(i % 8, 0x65, &simScreen[i]);
+        screens[i] = new Projecta(*mux[i / 8], i % 8);
+    }
+    // Added in scrambled order, the fleet sorts them
+    for(uint8_t k=0;k<SCREENS;k++){
+        fleet.add(*screens[(k * 7) % SCREENS]);
+    }
+    // Channel 0 of every mux, then channel 1...
+    for(uint8_t i=0;i<SCREENS;i++){
+        interleaved[i] = screens[(i % MUXES) * 8 + i / MUXES];
+    }
+    if(fleet.begin() != PROJ_OK){
+        printf("fleet begin() failed\n");
+        return 1;
+    }
+    for(uint8_t k=0;k<10;k++){
+        fleet.loop();   // first frames of every screen
+    }
+
+    printf("%u screens, %u muxes, 400 kHz, 10 s\n", SCREENS, MUXES);
+    printf("%-22s %9s %9s %11s %10s %7s %7s\n", "", "frames/s", "reads/s", "switches/s",
+        "worst ms", "busy", "errors");
+    Result a = run(&fleet, NULL);
+    print("ProjectaFleet", a);
+    Result b = run(NULL, interleaved);
+    print("loop() across muxes", b);
+    return a.errors || b.errors || !a.frames;
+}
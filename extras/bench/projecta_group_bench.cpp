@@ -0,0 +1,161 @@
+/* Projecta group benchmark
+ * Eight screens showing the same reading: a ProjectaGroup
+ * (leader and six mirrors behind one mux, one mirror on
+ * Wire1) against eight Projecta objects behind a second mux,
+ * each given the same values. Reports RAM and CPU per
+ * update, then checks every mirror shows the leader's frame,
+ * reports its own buttons and recovers from a disconnect.
+ * See extras/README.md.
+ */
+#include <ProjectaGroup.h>
+#include <Wire.h>
+#include <stdio.h>
+#include <time.h>
+
+#define SCREENS 8
+#define UPDATES 20000
+
+static SimMux groupMux, soloMux;
+static SimScreen groupScreen[SCREENS], soloScreen[SCREENS];
+static uint8_t lastMember = 0xFF, lastButtons = 0;
+
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void onButtons(uint8_t member, uint8_t buttons){
+    lastMember = member;
+    lastButtons = buttons;
+}
+
+/* One reading on every screen of a set */
+static void update(Projecta& proj, int32_t k){
+    proj.beginUpdate();
+    proj.setVoltage_mV(12000 + k % 2000);
+    proj.setBatteryBar(k % 5);
+    proj.setLed(LED_GREEN_FLASHING, k & 1);
+    proj.commit();
+}
+
+/* Function to check every group screen shows the leader's frame
+ * @returns -> screens that differ
+ */
+static uint8_t mismatches(Projecta& leader){
+    uint8_t frame[10], n = 0;
+    leader.getFrame(frame);
+    for(uint8_t i=0;i<SCREENS;i++){
+        n += memcmp(groupScreen[i].getFrame(), frame, 10) != 0;
+    }
+    return n;
+}
+
+int main(){
+    Wire.attachDevice(0x70, &groupMux);
+    Wire.attachDevice(0x71, &soloMux);
+    ProjectaMux muxA(Wire, 0x70), muxB(Wire, 0x71);
+    for(uint8_t i=0;i<SCREENS;i++){
+        soloMux.attachDevice(i, 0x65, &soloScreen[i]);
+    }
+    for(uint8_t i=0;i<SCREENS - 1;i++){
+        groupMux.attachDevice(i, 0x65, &groupScreen[i]);
+    }
+    Wire1.attachDevice(0x65, &groupScreen[SCREENS - 1]);
+
+    Projecta leader(muxA, 0);
+    ProjectaGroup group(leader);
+    for(uint8_t i=1;i<SCREENS - 1;i++){
+        group.add(muxA, i);
+    }
+    group.add(Wire1);
+    group.setButtonCallback(onButtons);
+    Projecta* solo[SCREENS];
+    for(uint8_t i=0;i<SCREENS;i++){
+        solo[i] = new Projecta(muxB, i);
+        solo[i]->begin();
+    }
+    if(group.begin() != PROJ_OK){
+        printf("group begin() failed\n");
+        return 1;
+    }
+
+    printf("%u screens showing the same reading, %u updates\n", SCREENS, UPDATES);
+    printf("RAM: %zu bytes as Projecta objects, %zu as a group (%zu per mirror, %u slots)\n",
+        SCREENS * sizeof(Projecta), sizeof(Projecta) + sizeof(ProjectaGroup), sizeof(projecta_mirror),
+        PROJECTA_MAX_GROUP);
+    hostUseManualClock(true);
+    uint64_t tSolo = 0, tGroup = 0;
+    for(int32_t k=0;k<UPDATES;k++){
+        uint64_t t = nowNs();
+        for(uint8_t i=0;i<SCREENS;i++){
+            update(*solo[i], k);
+            solo[i]->loop();
+        }
+        tSolo += nowNs() - t;
+        t = nowNs();
+        update(leader, k);
+        group.loop();
+        tGroup += nowNs() - t;
+        hostAdvanceMicros(10000);
+    }
+    printf("CPU per update incl. simulated bus: %.0f ns as Projecta objects, %.0f ns as a group\n",
+        (double)tSolo / UPDATES, (double)tGroup / UPDATES);
+    uint32_t soloFrames = 0, groupFrames = 0;
+    for(uint8_t i=0;i<SCREENS;i++){
+        soloFrames += soloScreen[i].getFramesReceived();
+        groupFrames += groupScreen[i].getFramesReceived();
+    }
+    printf("frames written: %u as Projecta objects, %u as a group\n", soloFrames, groupFrames);
+
+    uint32_t failures = mismatches(leader);
+    for(uint8_t i=0;i<SCREENS;i++){
+        failures += groupScreen[i].getChecksumErrors() + groupScreen[i].getLengthErrors();
+    }
+
+    // A button on the third mirror is reported for that mirror only
+    groupScreen[3].setButtons(BUTTON_VOLT_AMP);
+    for(uint8_t k=0;k<10;k++){
+        group.loop();
+        hostAdvanceMicros(10000);
+    }
+    bool buttonsOk = group.getButtons(2) == BUTTON_VOLT_AMP && lastMember == 2 && lastButtons == BUTTON_VOLT_AMP;
+    for(uint8_t i=0;i<group.size();i++){
+        buttonsOk = buttonsOk && (i == 2 || group.getButtons(i) == 0);
+    }
+
+    // A bounce seen on a single poll of the first mirror is not reported
+    lastMember = 0xFF;
+    hostAdvanceMicros(50000);
+    groupScreen[1].setButtons(BUTTON_BATTERY_TYPE);
+    group.loop();
+    groupScreen[1].setButtons(0);
+    for(uint8_t k=0;k<10;k++){
+        group.loop();
+        hostAdvanceMicros(10000);
+    }
+    buttonsOk = buttonsOk && group.getButtons(0) == 0 && lastMember == 0xFF;
+    printf("mirror buttons: %s\n", buttonsOk ? "ok" : "wrong");
+    failures += !buttonsOk;
+
+    // The fifth mirror drops off, the others carry on, then it comes back
+    groupScreen[5].setConnected(false);
+    for(int32_t k=0;k<50;k++){
+        update(leader, k);
+        group.loop();
+        hostAdvanceMicros(10000);
+    }
+    bool downOk = !group.isConnected(4) && group.getErrors(4) > 0 && group.getErrors(3) == 0 &&
+        memcmp(groupScreen[6].getFrame(), groupScreen[0].getFrame(), 10) == 0;
+    groupScreen[5].setConnected(true);
+    for(uint8_t k=0;k<200;k++){
+        group.loop();
+        hostAdvanceMicros(10000);
+    }
+    bool upOk = group.isConnected(4) && mismatches(leader) == 0;
+    printf("disconnect: %s, reconnect: %s (%u errors on the mirror)\n", downOk ? "ok" : "wrong",
+        upOk ? "ok" : "wrong", group.getErrors(4));
+    failures += !downOk + !upOk;
+    hostUseManualClock(false);
+    return failures ? 1 : 0;
+}
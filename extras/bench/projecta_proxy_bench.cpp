@@ -0,0 +1,173 @@
+/* Projecta proxy latency benchmark
+ * A simulated charger on Wire talks to ProjectaProxy, which
+ * drives a simulated screen on Wire1. Reports the forwarding
+ * latency from the end of the charger's frame write to the
+ * end of the screen write, and the button relay latency, for a few bus
+ * speeds and proxy call periods. See extras/README.md.
+ */
+#include <ProjectaProxy.h>
+#include <Wire.h>
+#include <stdio.h>
+
+/* Charger side frame encoding, independent of the library */
+static void chargerFrame(uint8_t* frame, uint32_t n, bool buzzer){
+    static const uint8_t digits[10] = {0xEB, 0x60, 0xC7, 0xE5, 0x6C, 0xAD, 0xAF, 0xE0, 0xEF, 0xED};
+    memset(frame, 0, 10);
+    frame[0] = 0x08;
+    frame[1] = digits[(n / 100) % 10];
+    frame[2] = digits[(n / 10) % 10] | 0x10;
+    frame[3] = digits[n % 10];
+    frame[7] = buzzer ? (1 << 5) : 0;
+    for(uint8_t i=0;i<9;i++){
+        frame[9] += frame[i];
+    }
+}
+
+struct Result{
+    uint32_t frames;
+    uint32_t maxLatency;
+    double avgLatency;
+    uint32_t maxButton;
+};
+
+/* Ten simulated seconds in 10 us ticks: the charger writes a
+ * new frame every 100 ms and reads the buttons every 20 ms,
+ * at times that drift against the proxy call period, so
+ * frames land anywhere between two proxy calls or during a
+ * screen transaction. Latency counts from the scheduled end
+ * of the charger's write; the charger side bus is made fast
+ * so its own transfer time does not shift the schedule.
+ */
+static Result run(ProjectaProxy& proxy, SimScreen& screen, uint32_t clock, uint32_t periodUs, bool held){
+    Wire1.setClock(clock);
+    Wire.setClock(100000000);
+    hostUseManualClock(true);
+    screen.resetCounters();
+    screen.setButtons(held ? BUTTON_VOLT_AMP : 0);
+    Result r = {0, 0, 0, 0};
+    uint64_t latencySum = 0;
+    uint32_t start = micros();
+    uint32_t nextFrame = start + 137, nextRead = start + 1013, nextCall = start;
+    uint32_t frameAt = 0, pressAt = start;
+    bool waiting = false, pressed = held;
+    uint32_t received = screen.getFramesReceived();
+    uint32_t n = 0;
+    while((uint32_t)(micros() - start) < 10000000UL){
+        uint32_t now = micros();
+        if(!waiting && (int32_t)(now - nextFrame) >= 0){
+            uint8_t frame[10];
+            chargerFrame(frame, n++, false);
+            Wire.simulateMasterWrite(frame, 10);
+            frameAt = nextFrame;
+            waiting = true;
+            nextFrame += 100003;
+        }
+        if((int32_t)(now - nextRead) >= 0){
+            uint8_t reply[3];
+            Wire.simulateMasterRead(reply, 3);
+            if(!held && pressed && (reply[0] & BUTTON_VOLT_AMP)){
+                uint32_t lat = micros() - pressAt;
+                if(lat > r.maxButton){
+                    r.maxButton = lat;
+                }
+                pressed = false;
+                screen.setButtons(0);
+            }
+            nextRead += 20011;
+        }
+        if(!held && !pressed && (uint32_t)(now - pressAt) >= 250007){
+            pressed = true;
+            pressAt = now;
+            screen.setButtons(BUTTON_VOLT_AMP);
+        }
+        if((int32_t)(micros() - nextCall) >= 0){
+            proxy.loop();
+            nextCall += periodUs;
+        }
+        if(waiting && screen.getFramesReceived() != received){
+            received = screen.getFramesReceived();
+            uint32_t lat = micros() - frameAt;
+            latencySum += lat;
+            if(lat > r.maxLatency){
+                r.maxLatency = lat;
+            }
+            r.frames++;
+            waiting = false;
+        }
+        hostAdvanceMicros(10);
+    }
+    hostUseManualClock(false);
+    r.avgLatency = r.frames ? (double)latencySum / r.frames : 0;
+    return r;
+}
+
+/* Overrides must reach the screen with a valid checksum */
+static bool checkOverrides(ProjectaProxy& proxy, SimScreen& screen){
+    proxy.maskBuzzer(true);
+    proxy.overrideValue(UNIT_AMP, 12500);
+    uint8_t frame[10];
+    chargerFrame(frame, 555, true);
+    Wire.simulateMasterWrite(frame, 10);
+    for(int i=0;i<4;i++){
+        proxy.loop();
+    }
+    const uint8_t* got = screen.getFrame();
+    bool ok = screen.getChecksumErrors() == 0 && got[0] == 0x80 && !(got[7] & (1 << 5));
+    proxy.clearOverrides();
+    chargerFrame(frame, 556, true);
+    Wire.simulateMasterWrite(frame, 10);
+    for(int i=0;i<4;i++){
+        proxy.loop();
+    }
+    return ok && memcmp(screen.getFrame(), frame, 10) == 0;
+}
+
+/* A slave that goes out of scope must free its slot and
+ * leave no handler behind for the next frame to call
+ */
+static bool checkSlaveRelease(void){
+    uint8_t frame[10];
+    chargerFrame(frame, 1, false);
+    for(uint8_t i=0;i<PROJECTA_MAX_SLAVES + 1;i++){
+        Projecta slave(Wire);
+        if(slave.beginSlave() != PROJ_OK){
+            return false;
+        }
+    }
+    Wire.simulateMasterWrite(frame, 10);
+    return true;
+}
+
+int main(){
+    SimScreen screen;
+    Wire1.attachDevice(0x65, &screen);
+    if(!checkSlaveRelease()){
+        printf("slave release check failed\n");
+        return 1;
+    }
+    ProjectaProxy proxy(Wire, Wire1);
+    if(proxy.begin() != PROJ_OK){
+        printf("begin() failed\n");
+        return 1;
+    }
+    if(!checkOverrides(proxy, screen)){
+        printf("override check failed\n");
+        return 1;
+    }
+    printf("%-8s %-8s %-8s %7s %12s %12s %14s\n", "clock", "period", "buttons", "frames",
+        "avg us", "worst us", "button worst");
+    const uint32_t clocks[2] = {100000, 400000};
+    const uint32_t periods[2] = {100, 1000};
+    for(uint8_t c=0;c<2;c++){
+        for(uint8_t p=0;p<2;p++){
+            for(uint8_t h=0;h<2;h++){
+                Result r = run(proxy, screen, clocks[c], periods[p], h);
+                printf("%-8u %-8u %-8s %7u %12.0f %12u %14u\n", clocks[c], periods[p],
+                    h ? "held" : "tapped", r.frames, r.avgLatency, r.maxLatency, r.maxButton);
+            }
+        }
+    }
+    printf("proxy max latency %u us, %u rejected, screen rejected %u\n", proxy.getMaxLatency(),
+        proxy.getFramesRejected(), screen.getChecksumErrors() + screen.getLengthErrors());
+    return screen.getChecksumErrors() || screen.getLengthErrors();
+}
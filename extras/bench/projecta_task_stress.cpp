@@ -0,0 +1,188 @@
+/* Projecta bus task stress test
+ * The application thread commits multi-field updates as fast
+ * as it can and drains button events while the bus task
+ * (a std::thread on the host) owns the simulated bus and a
+ * third thread flips the screen buttons. Every frame the
+ * screen receives must be a whole update, events must arrive
+ * in order with gaps only where drops were counted, and
+ * between gaps every button must alternate pressed/released.
+ * A second phase runs the page carousel from loop() against
+ * the task. Build with -pthread, and with -fsanitize=thread
+ * to look for data races.
+ */
+#include <Projecta.h>
+#include <ProjectaDecoder.h>
+#include <Wire.h>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+/* Screen model checking that value and bar always match,
+ * i.e. no frame is a mix of two updates
+ */
+class CheckScreen : public SimDevice{
+    public:
+        std::atomic<uint8_t> buttons{0};
+        std::atomic<uint32_t> frames{0};
+        uint32_t torn = 0;
+        uint32_t invalid = 0;
+        std::atomic<bool> pages{false};    // page phase: values are not paired with the bar
+        uint16_t units = 0;     // projecta_unit values seen in the page phase, as bits
+        bool simWrite(const uint8_t* data, size_t len){
+            if(len == 0){
+                return true;
+            }
+            projecta_telemetry tel;
+            if(len != 10 || projectaDecodeFrame(data, tel) == PROJ_CHECKSUM_INVALID){
+                invalid++;
+                return true;
+            }
+            frames++;
+            if(pages){
+                units |= 1 << tel.unit;
+            }else if(tel.raw >= 100 && tel.bar != tel.raw % 5){   // blank start frame has raw -1
+                torn++;
+            }
+            return true;
+        }
+        size_t simRead(uint8_t* data, size_t len){
+            uint8_t reply[3] = {buttons.load(), 0, 0};
+            size_t n = len < 3 ? len : 3;
+            memcpy(data, reply, n);
+            return n;
+        }
+};
+
+static uint64_t nowNs(void){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Event order checker. Sequence numbers may only skip by the
+ * events the library counted as dropped. After a gap the held
+ * state is taken from the event (the state after its whole
+ * debounced change) and the rest of that change is not checked.
+ */
+struct EventCheck{
+    uint32_t events = 0;
+    uint32_t skipped = 0;
+    uint32_t sequenceErrors = 0;
+    uint8_t expected = 0;
+    uint8_t held = 0;
+    bool resync = false;
+    uint32_t resyncMillis = 0;
+
+    void drain(Projecta& proj){
+        projecta_button_event ev;
+        while(proj.readButtonEvent(ev)){
+            uint8_t gap = (uint8_t)(ev.seq - expected);
+            expected = ev.seq + 1;
+            events++;
+            if(gap >= 128){
+                sequenceErrors++;   // Went backwards
+            }else if(gap){
+                skipped += gap;
+                held = ev.held;
+                resync = true;
+                resyncMillis = ev.millis;
+            }else if(resync && ev.millis == resyncMillis){
+                continue;
+            }else if(ev.type == EVENT_PRESSED){
+                resync = false;
+                sequenceErrors += (held & ev.buttons) != 0;
+                held |= ev.buttons;
+            }else if(ev.type == EVENT_RELEASED){
+                resync = false;
+                sequenceErrors += (held & ev.buttons) != ev.buttons;
+                held &= ~ev.buttons;
+            }
+        }
+    }
+};
+
+int main(int argc, char** argv){
+    uint32_t seconds = argc > 1 ? (uint32_t)atol(argv[1]) : 2;
+    CheckScreen screen;
+    Wire.attachDevice(0x65, &screen);
+    Projecta proj(Wire);
+    if(proj.begin() != PROJ_OK || proj.startBusTask() != PROJ_OK){
+        printf("start failed\n");
+        return 1;
+    }
+
+    std::atomic<bool> run{true};
+    std::atomic<uint32_t> flips{0};
+    std::thread presser([&]{
+        uint32_t i = 0;
+        while(run.load()){
+            screen.buttons.store((uint8_t)((i++ * 5) & 0x0F));
+            flips++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(37));
+        }
+        screen.buttons.store(0);
+    });
+
+    EventCheck check;
+    uint32_t commits = 0;
+    uint64_t worstCommit = 0;
+    uint64_t end = nowNs() + seconds * 1000000000ULL;
+    uint32_t n = 100;
+    while(nowNs() < end){
+        uint64_t t = nowNs();
+        proj.beginUpdate();
+        proj.setVoltage_mV((int32_t)n * 1000);
+        proj.setBatteryBar(n % 5);
+        proj.commit();
+        t = nowNs() - t;
+        if(t > worstCommit){
+            worstCommit = t;
+        }
+        commits++;
+        if(++n > 999){
+            n = 100;
+        }
+        check.drain(proj);
+    }
+    uint32_t frames = screen.frames;
+
+    // Page carousel rotating from this thread while the task
+    // sends the frames
+    screen.pages = true;
+    proj.addPage(UNIT_VOLT, NULL, 3);
+    proj.addPage(UNIT_AMP, NULL, 5);
+    proj.addPage(UNIT_PERCENT, NULL, 7);
+    uint32_t flipsSeen = 0, deadlineErrors = 0;
+    uint8_t lastPage = 0;
+    end = nowNs() + seconds * 500000000ULL;
+    for(int32_t k=0;nowNs() < end;k++){
+        proj.setPageValue(k % 3, (k % 9000) * 100);
+        proj.loop();
+        uint32_t wait = proj.getNextDeadline() - millis();
+        deadlineErrors += (int32_t)wait > 50;   // at most the idle poll interval
+        if(proj.getPage() != lastPage){
+            lastPage = proj.getPage();
+            flipsSeen++;
+        }
+        check.drain(proj);
+    }
+    proj.clearPages();
+    run.store(false);
+    presser.join();
+    proj.stopBusTask();
+    check.drain(proj);
+
+    uint16_t dropped = proj.getButtonEventsDropped();
+    printf("%u commits (%.0f/s, worst %.1f us), %u frames on the bus\n", commits,
+        commits / (double)seconds, worstCommit / 1e3, screen.frames.load());
+    printf("%u torn frames, %u invalid frames\n", screen.torn, screen.invalid);
+    printf("%u button changes, %u events, %u dropped, %u skipped in sequence, %u sequence errors\n",
+        flips.load(), check.events, dropped, check.skipped, check.sequenceErrors);
+    bool pagesOk = flipsSeen > 10 && screen.units == ((1 << UNIT_VOLT) | (1 << UNIT_AMP) | (1 << UNIT_PERCENT)) &&
+        !deadlineErrors;
+    printf("pages: %u flips, %u frames, %u late deadlines: %s\n", flipsSeen, screen.frames.load() - frames,
+        deadlineErrors, pagesOk ? "ok" : "wrong");
+    bool ok = frames > 0 && !screen.torn && !screen.invalid && check.events > 0 &&
+        !check.sequenceErrors && check.skipped == dropped && pagesOk;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+/* Host Arduino shim - Projecta library
+ * Clock, pin and Print/Stream implementations for
+ * plain Linux builds.
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+HostSerial Serial;
+
+static bool _manualClock = false;
+static uint64_t _manualMicros = 0;
+static uint8_t _pinLevels[256];
+static bool _pinHeld[256];
+static void (*_pinHook)(uint8_t, uint8_t) = NULL;
+
+static uint64_t _realOffset = 0;
+
+static uint64_t monotonicMicros(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    static uint64_t start = 0;
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+    if(!start){
+        start = now;
+    }
+    return now - start + _realOffset;
+}
+
+/* Switching between the manual and the real clock never
+ * moves time backwards: whichever clock is ahead wins.
+ */
+void hostUseManualClock(bool manual){
+    uint64_t real = monotonicMicros();
+    if(manual){
+        if(!_manualClock && real > _manualMicros){
+            _manualMicros = real;
+        }
+    }else if(_manualClock && _manualMicros > real){
+        _realOffset += _manualMicros - real;
+    }
+    _manualClock = manual;
+}
+
+void hostAdvanceMicros(uint32_t us){
+    _manualMicros += us;
+}
+
+unsigned long micros(void){
+    return (unsigned long)(uint32_t)(_manualClock ? _manualMicros : monotonicMicros());
+}
+
+unsigned long millis(void){
+    return (unsigned long)(uint32_t)((_manualClock ? _manualMicros : monotonicMicros()) / 1000ULL);
+}
+
+void delay(unsigned long ms){
+    if(_manualClock){
+        _manualMicros += (uint64_t)ms * 1000ULL;
+    }else{
+        usleep(ms * 1000UL);
+    }
+}
+
+void delayMicroseconds(unsigned int us){
+    if(_manualClock){
+        _manualMicros += us;
+    }else{
+        usleep(us);
+    }
+}
+
+/* Pins float high (pulled up) until driven low */
+void pinMode(uint8_t pin, uint8_t mode){
+    if(mode != OUTPUT){
+        _pinLevels[pin] = HIGH;
+    }
+    if(_pinHook){
+        _pinHook(pin, _pinLevels[pin]);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val){
+    _pinLevels[pin] = val ? HIGH : LOW;
+    if(_pinHook){
+        _pinHook(pin, _pinLevels[pin]);
+    }
+}
+
+int digitalRead(uint8_t pin){
+    return _pinHeld[pin] ? LOW : _pinLevels[pin];
+}
+
+void hostHoldPinLow(uint8_t pin, bool hold){
+    _pinHeld[pin] = hold;
+}
+
+void hostSetPinHook(void (*hook)(uint8_t pin, uint8_t level)){
+    _pinHook = hook;
+}
+
+void noInterrupts(void){}
+void interrupts(void){}
+
+String::String(double v, unsigned char decimals){
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+    _s = buf;
+}
+
+int String::indexOf(char c) const{
+    size_t i = _s.find(c);
+    return i == std::string::npos ? -1 : (int)i;
+}
+
+String String::substring(unsigned int from, unsigned int to) const{
+    if(from > _s.length()){
+        return String();
+    }
+    return String(_s.substr(from, to > from ? to - from : 0));
+}
+
+size_t Print::write(const uint8_t* buf, size_t len){
+    size_t n = 0;
+    while(len--){
+        n += write(*buf++);
+    }
+    return n;
+}
+
+size_t Print::print(const char* s){
+    return write(s);
+}
+
+size_t Print::print(const __FlashStringHelper* s){
+    return write(reinterpret_cast<const char*>(s));
+}
+
+size_t Print::print(const String& s){
+    return write((const uint8_t*)s.c_str(), s.length());
+}
+
+size_t Print::print(char c){
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned long v, int base){
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", v);
+    return write(buf);
+}
+
+size_t Print::print(long v, int base){
+    char buf[24];
+    if(base == HEX){
+        snprintf(buf, sizeof(buf), "%lX", (unsigned long)v);
+    }else{
+        snprintf(buf, sizeof(buf), "%ld", v);
+    }
+    return write(buf);
+}
+
+size_t Print::print(double v, int digits){
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(buf);
+}
+
+size_t Print::println(void){
+    return write((uint8_t)'\n');
+}
+
+size_t Stream::readBytes(uint8_t* buf, size_t len){
+    size_t n = 0;
+    while(n < len && available()){
+        buf[n++] = (uint8_t)read();
+    }
+    return n;
+}
+
+size_t HostSerial::write(uint8_t c){
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HostSerial::write(const uint8_t* buf, size_t len){
+    return fwrite(buf, 1, len, stdout);
+}
+
+void HostSerial::flush(){
+    fflush(stdout);
+}
@@ -0,0 +1,145 @@
+/* Host Arduino shim - Projecta library
+ * Minimal stand-in for the Arduino core so the library
+ * can be built and benchmarked on a plain Linux host.
+ * Only what the library (and its host tools) use is
+ * provided here.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+
+#define PROJECTA_HOST
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+// Flash helpers are no-ops on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(const void* const*)(addr))
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void noInterrupts(void);
+void interrupts(void);
+
+/* Host clock control. By default millis()/micros() follow
+ * the real monotonic clock. Switching to the manual clock
+ * freezes time so simulations can step it explicitly.
+ */
+void hostUseManualClock(bool manual);
+void hostAdvanceMicros(uint32_t us);
+
+/* Host pin control. A held pin reads LOW whatever is written
+ * to it (a slave clamping SDA); the hook sees every level
+ * written by pinMode()/digitalWrite().
+ */
+void hostHoldPinLow(uint8_t pin, bool hold);
+void hostSetPinHook(void (*hook)(uint8_t pin, uint8_t level));
+
+class String{
+    private:
+        std::string _s;
+    public:
+        String(){}
+        String(const char* s) : _s(s ? s : ""){}
+        String(const std::string& s) : _s(s){}
+        String(const __FlashStringHelper* s) : _s(reinterpret_cast<const char*>(s)){}
+        String(int v) : _s(std::to_string(v)){}
+        String(unsigned int v) : _s(std::to_string(v)){}
+        String(long v) : _s(std::to_string(v)){}
+        String(unsigned long v) : _s(std::to_string(v)){}
+        String(double v, unsigned char decimals = 2);
+        const char* c_str() const { return _s.c_str(); }
+        unsigned int length() const { return (unsigned int)_s.length(); }
+        char charAt(unsigned int i) const { return i < _s.length() ? _s[i] : 0; }
+        char operator[](unsigned int i) const { return charAt(i); }
+        String& operator+=(const String& o){ _s += o._s; return *this; }
+        String& operator+=(const char* o){ _s += o; return *this; }
+        String& operator+=(char c){ _s += c; return *this; }
+        bool operator==(const String& o) const { return _s == o._s; }
+        bool operator==(const char* o) const { return _s == o; }
+        bool operator!=(const String& o) const { return _s != o._s; }
+        bool operator!=(const char* o) const { return _s != o; }
+        friend String operator+(const String& a, const String& b){ return String(a._s + b._s); }
+        bool equals(const String& o) const { return _s == o._s; }
+        int indexOf(char c) const;
+        String substring(unsigned int from, unsigned int to) const;
+        long toInt() const { return strtol(_s.c_str(), NULL, 10); }
+        double toDouble() const { return strtod(_s.c_str(), NULL); }
+};
+
+#define DEC 10
+#define HEX 16
+
+class Print{
+    public:
+        virtual ~Print(){}
+        virtual size_t write(uint8_t) = 0;
+        virtual size_t write(const uint8_t* buf, size_t len);
+        size_t write(const char* str){ return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+        size_t print(const char*);
+        size_t print(const __FlashStringHelper*);
+        size_t print(const String&);
+        size_t print(char);
+        size_t print(unsigned long, int base = DEC);
+        size_t print(long, int base = DEC);
+        size_t print(unsigned int v, int base = DEC){ return print((unsigned long)v, base); }
+        size_t print(int v, int base = DEC){ return print((long)v, base); }
+        size_t print(unsigned char v, int base = DEC){ return print((unsigned long)v, base); }
+        size_t print(double, int digits = 2);
+        size_t println(void);
+        template<typename T> size_t println(T v){ size_t n = print(v); return n + println(); }
+        template<typename T> size_t println(T v, int f){ size_t n = print(v, f); return n + println(); }
+};
+
+class Stream : public Print{
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+        size_t readBytes(uint8_t* buf, size_t len);
+        size_t readBytes(char* buf, size_t len){ return readBytes((uint8_t*)buf, len); }
+};
+
+/* Serial writes to stdout and never has input */
+class HostSerial : public Stream{
+    public:
+        void begin(unsigned long){}
+        size_t write(uint8_t c);
+        size_t write(const uint8_t* buf, size_t len);
+        using Print::write;
+        int available(){ return 0; }
+        int read(){ return -1; }
+        int peek(){ return -1; }
+        void flush();
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,348 @@
+/* Host Wire shim - Projecta library
+ * Simulated bus transactions and the ICREMOTE screen model.
+ */
+#include <Wire.h>
+
+TwoWire Wire;
+TwoWire Wire1;
+
+SimScreen::SimScreen(){
+    memset(_frame, 0, sizeof(_frame));
+}
+
+/* Frames are accepted only when they are 10 bytes long and
+ * byte 9 holds the sum of bytes 0-8, like the real screen.
+ * Address-only probes (len 0) are always acknowledged.
+ */
+bool SimScreen::simWrite(const uint8_t* data, size_t len){
+    if(len == 0){
+        return true;
+    }
+    if(len != 10){
+        _lengthErrors++;
+        return true;
+    }
+    uint8_t frame[10];
+    memcpy(frame, data, 10);
+    int8_t bit = glitch();
+    if(bit == 0){
+        return false;
+    }else if(bit > 0){
+        frame[(_seed >> 4) % 10] ^= (uint8_t)(1 << (bit - 1));
+    }
+    data = frame;
+    uint8_t sum = 0;
+    for(int i=0;i<9;i++){
+        sum += data[i];
+    }
+    if(sum != data[9]){
+        _checksumErrors++;
+        return true;
+    }
+    memcpy(_frame, data, 10);
+    _framesReceived++;
+    return true;
+}
+
+size_t SimScreen::simRead(uint8_t* data, size_t len){
+    uint8_t reply[3] = {_buttons, 0x00, 0x00};
+    size_t n = len < 3 ? len : 3;
+    int8_t bit = glitch();
+    if(bit == 0){
+        return 0;
+    }else if(bit > 0){
+        reply[(_seed >> 4) % 3] ^= (uint8_t)(1 << (bit - 1));
+    }
+    memcpy(data, reply, n);
+    _reads++;
+    return n;
+}
+
+/* Decides whether a transfer above the clock limit fails
+ * (deterministic, so runs repeat)
+ * @returns -> -1 no error, 0 NACK, 1-8 bit to flip
+ */
+int8_t SimScreen::glitch(){
+    if(!_clockLimit || _clock <= _clockLimit){
+        return -1;
+    }
+    _seed = _seed * 1664525 + 1013904223;
+    if((_seed >> 8) % 1000 >= _errorsPerThousand){
+        return -1;
+    }
+    _glitches++;
+    return (_seed >> 24) & 1 ? 0 : (int8_t)(1 + ((_seed >> 20) & 7));
+}
+
+void SimScreen::resetCounters(){
+    _glitches = 0;
+    _framesReceived = 0;
+    _checksumErrors = 0;
+    _lengthErrors = 0;
+    _reads = 0;
+}
+
+SimMux::SimMux(){
+    memset(_channels, 0, sizeof(_channels));
+}
+
+bool SimMux::simWrite(const uint8_t* data, size_t len){
+    if(len == 1){
+        _mask = data[0];
+        _selects++;
+    }
+    return true;
+}
+
+size_t SimMux::simRead(uint8_t* data, size_t len){
+    if(len){
+        data[0] = _mask;
+    }
+    return len ? 1 : 0;
+}
+
+uint8_t SimMux::simRoute(uint8_t address, SimDevice*& found){
+    uint8_t n = 0;
+    for(uint8_t i=0;i<8;i++){
+        SimDevice* dev = _channels[i].device;
+        if((_mask & (1 << i)) && dev && _channels[i].address == address && dev->simPresent()){
+            if(!n++){
+                found = dev;
+            }
+        }
+    }
+    return n;
+}
+
+bool SimMux::attachDevice(uint8_t channel, uint8_t address, SimDevice* device){
+    if(channel > 7){
+        return false;
+    }
+    _channels[channel].address = address;
+    _channels[channel].device = device;
+    return true;
+}
+
+/* Devices attached to the bus itself win; otherwise every
+ * mux is asked for the address on its open channels, and
+ * more than one answer counts as a collision
+ */
+SimDevice* TwoWire::findDevice(uint8_t address){
+    for(uint8_t i=0;i<_numDevices;i++){
+        if(_devices[i].address == address){
+            return _devices[i].device->simPresent() ? _devices[i].device : NULL;
+        }
+    }
+    SimDevice* found = NULL;
+    uint8_t answers = 0;
+    for(uint8_t i=0;i<_numDevices;i++){
+        SimDevice* dev = NULL;
+        answers += _devices[i].device->simRoute(address, dev);
+        if(dev && !found){
+            found = dev;
+        }
+    }
+    if(answers > 1){
+        _collisions++;
+    }
+    return found;
+}
+
+/* Account for the time the transfer occupies the bus:
+ * start + address byte + data bytes, 9 clocks per byte.
+ * With the manual host clock this also advances time.
+ */
+void TwoWire::busTime(size_t bytes){
+    uint32_t us = (uint32_t)(((bytes + 1) * 9 + 2) * 1000000ULL / _clock);
+    _busMicros += us;
+    hostAdvanceMicros(us);
+}
+
+void TwoWire::beginTransmission(uint8_t address){
+    _txAddress = address;
+    _txLength = 0;
+    _transmitting = true;
+}
+
+/* Returns 0 on success, 2 on address NACK as the Arduino
+ * core does.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop){
+    (void)sendStop;
+    _transmitting = false;
+    _transactions++;
+    if(_stuckClocks){
+        busTime(0);
+        return 4;
+    }
+    SimDevice* dev = findDevice(_txAddress);
+    if(!dev){
+        busTime(0);
+        _nacks++;
+        return 2;
+    }
+    busTime(_txLength);
+    _bytesWritten += _txLength;
+    dev->simClock(_clock);
+    if(!dev->simWrite(_txBuffer, _txLength)){
+        _nacks++;
+        return 3;
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop){
+    (void)sendStop;
+    _transactions++;
+    _rxIndex = 0;
+    _rxLength = 0;
+    if(quantity > SIM_BUFFER_LENGTH){
+        quantity = SIM_BUFFER_LENGTH;
+    }
+    SimDevice* dev = _stuckClocks ? NULL : findDevice(address);
+    if(!dev){
+        busTime(0);
+        _nacks++;
+        return 0;
+    }
+    dev->simClock(_clock);
+    _rxLength = dev->simRead(_rxBuffer, quantity);
+    busTime(_rxLength);
+    _bytesRead += _rxLength;
+    return (uint8_t)_rxLength;
+}
+
+size_t TwoWire::write(uint8_t data){
+    if(_transmitting || _inRequest){
+        if(_txLength >= SIM_BUFFER_LENGTH){
+            return 0;
+        }
+        _txBuffer[_txLength++] = data;
+        return 1;
+    }
+    return 0;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len){
+    size_t n = 0;
+    while(n < len && write(data[n])){
+        n++;
+    }
+    return n;
+}
+
+int TwoWire::available(){
+    return (int)(_rxLength - _rxIndex);
+}
+
+int TwoWire::read(){
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek(){
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1;
+}
+
+bool TwoWire::attachDevice(uint8_t address, SimDevice* device){
+    detachDevice(address);
+    if(_numDevices >= SIM_MAX_DEVICES){
+        return false;
+    }
+    _devices[_numDevices].address = address;
+    _devices[_numDevices].device = device;
+    _numDevices++;
+    return true;
+}
+
+void TwoWire::detachDevice(uint8_t address){
+    for(uint8_t i=0;i<_numDevices;i++){
+        if(_devices[i].address == address){
+            _devices[i] = _devices[--_numDevices];
+            return;
+        }
+    }
+}
+
+/* Act as a remote master writing to this bus while it is
+ * in slave mode. Runs the onReceive handler synchronously.
+ * @returns -> bytes delivered, 0 if nobody is listening
+ */
+size_t TwoWire::simulateMasterWrite(const uint8_t* data, size_t len){
+    if(_slaveAddress < 0 || !_onReceive){
+        return 0;
+    }
+    if(len > SIM_BUFFER_LENGTH){
+        len = SIM_BUFFER_LENGTH;
+    }
+    memcpy(_rxBuffer, data, len);
+    _rxLength = len;
+    _rxIndex = 0;
+    busTime(len);
+    _bytesRead += len;
+    _onReceive((int)len);
+    return len;
+}
+
+/* Act as a remote master reading from this bus while it is
+ * in slave mode. Runs the onRequest handler synchronously
+ * and returns what it wrote.
+ */
+size_t TwoWire::simulateMasterRead(uint8_t* data, size_t len){
+    if(_slaveAddress < 0 || !_onRequest){
+        return 0;
+    }
+    _txLength = 0;
+    _inRequest = true;
+    _onRequest();
+    _inRequest = false;
+    size_t n = _txLength < len ? _txLength : len;
+    memcpy(data, _txBuffer, n);
+    _txLength = 0;
+    busTime(n);
+    _bytesWritten += n;
+    return n;
+}
+
+/* Model a slave that lost sync mid-byte and clamps SDA low.
+ * Every transaction fails (endTransmission() returns 4) and
+ * SDA reads LOW until SCL has been toggled `clocks` times
+ * through pinMode()/digitalWrite(), as in the usual recovery.
+ * Needs the pins from begin(sda, scl).
+ * @returns -> false if the bus was started without pins
+ */
+bool TwoWire::simulateStuckBus(uint8_t clocks){
+    if(_sda < 0 || _scl < 0 || !clocks){
+        return false;
+    }
+    _stuckClocks = clocks;
+    _sclLevel = HIGH;
+    hostHoldPinLow((uint8_t)_sda, true);
+    hostSetPinHook(pinHook);
+    return true;
+}
+
+/* Counts SCL rising edges on both buses while stuck */
+void TwoWire::pinHook(uint8_t pin, uint8_t level){
+    TwoWire* buses[2] = {&Wire, &Wire1};
+    for(uint8_t i=0;i<2;i++){
+        TwoWire* bus = buses[i];
+        if(!bus->_stuckClocks || pin != bus->_scl){
+            continue;
+        }
+        if(level == HIGH && bus->_sclLevel == LOW){
+            if(--bus->_stuckClocks == 0){
+                hostHoldPinLow((uint8_t)bus->_sda, false);
+            }
+        }
+        bus->_sclLevel = level;
+    }
+}
+
+void TwoWire::resetCounters(){
+    _transactions = 0;
+    _nacks = 0;
+    _bytesWritten = 0;
+    _bytesRead = 0;
+    _busMicros = 0;
+    _collisions = 0;
+}
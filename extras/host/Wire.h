@@ -0,0 +1,174 @@
+/* Host Wire shim - Projecta library
+ * Simulated TwoWire bus for plain Linux builds. Devices
+ * are attached to a bus by address; SimScreen models the
+ * ICREMOTE screen that answers at 0x65 and SimMux a
+ * TCA9548A with devices behind its channels.
+ */
+#ifndef TwoWire_h
+#define TwoWire_h
+#include <Arduino.h>
+
+#define SIM_BUFFER_LENGTH 32
+#define SIM_MAX_DEVICES 8
+
+/* A device on the simulated bus. simWrite() receives one
+ * complete master write, simRead() fills one master read.
+ */
+class SimDevice{
+    public:
+        virtual ~SimDevice(){}
+        virtual bool simWrite(const uint8_t* data, size_t len) = 0; // false = NACK
+        virtual size_t simRead(uint8_t* data, size_t len) = 0;
+        virtual bool simPresent(){ return true; }
+        // Devices behind an open mux channel that answer at
+        // address: returns how many (more than one collide on
+        // the bus) and sets found to the first
+        virtual uint8_t simRoute(uint8_t address, SimDevice*& found){ (void)address; (void)found; return 0; }
+        // Bus clock of the transfer about to start
+        virtual void simClock(uint32_t hz){ (void)hz; }
+};
+
+/* Model of the ICREMOTE screen. Accepts 10 byte frames,
+ * verifies the checksum and answers reads with the button
+ * state in byte 0. With a clock limit set, transfers faster
+ * than the limit fail at the given rate, as over a long or
+ * heavily loaded cable: half are NACKed, the rest arrive
+ * with a flipped bit.
+ */
+class SimScreen : public SimDevice{
+    private:
+        uint8_t _frame[10];
+        uint8_t _buttons = 0;
+        bool _connected = true;
+        uint32_t _framesReceived = 0;
+        uint32_t _checksumErrors = 0;
+        uint32_t _lengthErrors = 0;
+        uint32_t _reads = 0;
+        uint32_t _clock = 100000;
+        uint32_t _clockLimit = 0;
+        uint16_t _errorsPerThousand = 0;
+        uint32_t _seed = 1;
+        uint32_t _glitches = 0;
+        int8_t glitch();
+    public:
+        SimScreen();
+        void simClock(uint32_t hz){ _clock = hz; }
+        bool simWrite(const uint8_t* data, size_t len);
+        size_t simRead(uint8_t* data, size_t len);
+        bool simPresent(){ return _connected; }
+        void setButtons(uint8_t buttons){ _buttons = buttons; }
+        void setConnected(bool connected){ _connected = connected; }
+        const uint8_t* getFrame(){ return _frame; }
+        uint32_t getFramesReceived(){ return _framesReceived; }
+        uint32_t getChecksumErrors(){ return _checksumErrors; }
+        uint32_t getLengthErrors(){ return _lengthErrors; }
+        uint32_t getReads(){ return _reads; }
+        void setClockLimit(uint32_t hz, uint16_t errorsPerThousand){ _clockLimit = hz; _errorsPerThousand = errorsPerThousand; }
+        uint32_t getGlitches(){ return _glitches; }
+        void resetCounters();
+};
+
+/* Model of a TCA9548A 8 channel mux. A one byte write sets
+ * the mask of open channels, a read returns it. Devices on
+ * open channels appear on the parent bus.
+ */
+class SimMux : public SimDevice{
+    private:
+        struct ChannelSlot{
+            uint8_t address;
+            SimDevice* device;
+        };
+        ChannelSlot _channels[8];
+        uint8_t _mask = 0;
+        uint32_t _selects = 0;
+    public:
+        SimMux();
+        bool simWrite(const uint8_t* data, size_t len);
+        size_t simRead(uint8_t* data, size_t len);
+        uint8_t simRoute(uint8_t address, SimDevice*& found);
+        bool attachDevice(uint8_t channel, uint8_t address, SimDevice* device);
+        uint8_t getMask(){ return _mask; }
+        uint32_t getSelects(){ return _selects; }
+        void resetCounters(){ _selects = 0; }
+};
+
+class TwoWire : public Stream{
+    private:
+        struct DeviceSlot{
+            uint8_t address;
+            SimDevice* device;
+        };
+        DeviceSlot _devices[SIM_MAX_DEVICES];
+        uint8_t _numDevices = 0;
+        uint8_t _txAddress = 0;
+        uint8_t _txBuffer[SIM_BUFFER_LENGTH];
+        size_t _txLength = 0;
+        bool _transmitting = false;
+        uint8_t _rxBuffer[SIM_BUFFER_LENGTH];
+        size_t _rxLength = 0;
+        size_t _rxIndex = 0;
+        uint32_t _clock = 100000;
+        int16_t _slaveAddress = -1;
+        bool _inRequest = false;
+        void (*_onReceive)(int) = NULL;
+        void (*_onRequest)(void) = NULL;
+        uint32_t _transactions = 0;
+        uint32_t _nacks = 0;
+        uint64_t _bytesWritten = 0;
+        uint64_t _bytesRead = 0;
+        uint64_t _busMicros = 0;
+        uint32_t _collisions = 0;
+        int _sda = -1;
+        int _scl = -1;
+        uint8_t _sclLevel = HIGH;
+        uint8_t _stuckClocks = 0;
+        SimDevice* findDevice(uint8_t address);
+        static void pinHook(uint8_t pin, uint8_t level);
+        void busTime(size_t bytes);
+    public:
+        TwoWire(){}
+        void begin(){ _slaveAddress = -1; }
+        void begin(uint8_t address){ _slaveAddress = address; }
+        void begin(int address){ begin((uint8_t)address); }
+        void begin(int sda, int scl){ _sda = sda; _scl = scl; begin(); }
+        void begin(int sda, int scl, uint32_t freq){ _sda = sda; _scl = scl; _clock = freq; begin(); }
+        void begin(uint8_t address, int sda, int scl, uint32_t freq){ _sda = sda; _scl = scl; if(freq){ _clock = freq; } begin(address); }
+        void end(){ _slaveAddress = -1; }
+        void setClock(uint32_t freq){ _clock = freq; }
+        uint32_t getClock(){ return _clock; }
+
+        void beginTransmission(uint8_t address);
+        void beginTransmission(int address){ beginTransmission((uint8_t)address); }
+        uint8_t endTransmission(bool sendStop = true);
+        uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+        uint8_t requestFrom(int address, int quantity){ return requestFrom((uint8_t)address, (uint8_t)quantity); }
+        size_t write(uint8_t);
+        size_t write(const uint8_t* data, size_t len);
+        using Print::write;
+        int available();
+        int read();
+        int peek();
+        void flush(){}
+        void onReceive(void (*handler)(int)){ _onReceive = handler; }
+        void onRequest(void (*handler)(void)){ _onRequest = handler; }
+
+        // Simulation hooks
+        bool attachDevice(uint8_t address, SimDevice* device);
+        void detachDevice(uint8_t address);
+        size_t simulateMasterWrite(const uint8_t* data, size_t len);
+        size_t simulateMasterRead(uint8_t* data, size_t len);
+        bool simulateStuckBus(uint8_t clocks);
+        bool isBusStuck(){ return _stuckClocks != 0; }
+        uint32_t getTransactions(){ return _transactions; }
+        uint32_t getNacks(){ return _nacks; }
+        uint64_t getBytesWritten(){ return _bytesWritten; }
+        uint64_t getBytesRead(){ return _bytesRead; }
+        uint64_t getBusMicros(){ return _busMicros; }
+        uint32_t getCollisions(){ return _collisions; }
+        void resetCounters();
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
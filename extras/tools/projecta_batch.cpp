@@ -0,0 +1,365 @@
+/* Projecta batch decoder
+ * Decodes large captures (a ProjectaTrace file or a file of
+ * raw 10 byte frames back to back) into columns with
+ * projectaDecodeFrames(), split across threads by chunk, and
+ * writes CSV or a packed column file. The bench mode checks
+ * the batch decoder against projectaDecodeFrame() and reports
+ * frames/s. See extras/README.md for building.
+ */
+#include <ProjectaDecoder.h>
+#include <ProjectaTrace.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define COLUMN_MAGIC "PJCL"
+#define COLUMN_VERSION 1
+
+static volatile uint32_t sinkOut;   // keeps the timed decode loop from being optimised out
+
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void){
+    fprintf(stderr,
+        "usage: projecta_batch decode <capture> [-t threads] [-c out.csv] [-p out.pjc]\n"
+        "       projecta_batch bench [frames] [-t threads]\n");
+}
+
+/* Decoded columns of a whole capture */
+struct Columns{
+    std::vector<uint32_t> micros;
+    std::vector<int32_t> milli;
+    std::vector<int16_t> raw;
+    std::vector<uint8_t> decimals, unit, battery, bar, leds, buzzer, checksumValid;
+
+    void resize(size_t n){
+        milli.resize(n);
+        raw.resize(n);
+        decimals.resize(n);
+        unit.resize(n);
+        battery.resize(n);
+        bar.resize(n);
+        leds.resize(n);
+        buzzer.resize(n);
+        checksumValid.resize(n);
+    }
+
+    /* Column pointers starting at frame first */
+    projecta_columns view(size_t first){
+        projecta_columns c = {&milli[first], &raw[first], &decimals[first], &unit[first], &battery[first],
+            &bar[first], &leds[first], &buzzer[first], &checksumValid[first]};
+        return c;
+    }
+};
+
+/* Function to split [0, count) into one chunk per thread,
+ * on 16 frame boundaries so every chunk but the last runs
+ * entirely on the vector path
+ * @input -> frames, threads, chunk index
+ * @returns -> first frame of the chunk (chunk == threads
+ * gives count)
+ */
+static size_t chunkStart(size_t count, unsigned threads, unsigned chunk){
+    size_t per = (count / threads + 15) & ~(size_t)15;
+    size_t start = per * chunk;
+    return chunk == threads || start > count ? count : start;
+}
+
+/* Decodes every frame on threads threads
+ * @returns -> frames with a bad checksum
+ */
+static size_t decodeParallel(const uint8_t* frames, size_t count, Columns& cols, unsigned threads){
+    std::vector<std::thread> pool;
+    std::vector<size_t> bad(threads, 0);
+    cols.resize(count);
+    for(unsigned k=0;k<threads;k++){
+        size_t first = chunkStart(count, threads, k);
+        size_t n = chunkStart(count, threads, k + 1) - first;
+        if(n == 0){
+            continue;
+        }
+        projecta_columns view = cols.view(first);
+        pool.push_back(std::thread([=, &bad](){
+            bad[k] = projectaDecodeFrames(frames + first * 10, n, view);
+        }));
+    }
+    size_t total = 0;
+    for(size_t k=0;k<pool.size();k++){
+        pool[k].join();
+    }
+    for(unsigned k=0;k<threads;k++){
+        total += bad[k];
+    }
+    return total;
+}
+
+/* Formats rows [first, last) as CSV */
+static void formatCsv(const Columns& cols, size_t first, size_t last, std::vector<char>& out){
+    char line[80];
+    for(size_t i=first;i<last;i++){
+        int n = snprintf(line, sizeof(line), "%u,%u,%d,%d,%u,%u,%u,%u,%u,%u\n", cols.micros[i], cols.unit[i],
+            cols.milli[i], cols.raw[i], cols.decimals[i], cols.battery[i], cols.bar[i], cols.leds[i],
+            cols.buzzer[i], cols.checksumValid[i]);
+        out.insert(out.end(), line, line + n);
+    }
+}
+
+/* CSV is formatted per chunk in parallel and written in order */
+static bool writeCsv(const char* path, const Columns& cols, unsigned threads){
+    FILE* f = fopen(path, "w");
+    if(!f){
+        perror(path);
+        return false;
+    }
+    size_t count = cols.milli.size();
+    std::vector<std::vector<char> > text(threads);
+    std::vector<std::thread> pool;
+    for(unsigned k=0;k<threads;k++){
+        size_t first = chunkStart(count, threads, k);
+        size_t last = chunkStart(count, threads, k + 1);
+        pool.push_back(std::thread([&, first, last, k](){
+            formatCsv(cols, first, last, text[k]);
+        }));
+    }
+    fputs("micros,unit,milli,raw,decimals,battery,bar,leds,buzzer,checksum\n", f);
+    for(unsigned k=0;k<threads;k++){
+        pool[k].join();
+        fwrite(text[k].data(), 1, text[k].size(), f);
+    }
+    return fclose(f) == 0;
+}
+
+template<typename T> static void writeColumn(FILE* f, const std::vector<T>& col){
+    fwrite(col.data(), sizeof(T), col.size(), f);
+}
+
+/* Packed column file: "PJCL", version, uint32 frame count,
+ * then each column back to back in host byte order: micros
+ * u32, milli i32, raw i16, decimals, unit, battery, bar,
+ * leds, buzzer, checksum u8
+ */
+static bool writePacked(const char* path, const Columns& cols){
+    FILE* f = fopen(path, "wb");
+    if(!f){
+        perror(path);
+        return false;
+    }
+    uint32_t count = (uint32_t)cols.milli.size();
+    uint8_t version = COLUMN_VERSION;
+    fwrite(COLUMN_MAGIC, 1, 4, f);
+    fwrite(&version, 1, 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+    writeColumn(f, cols.micros);
+    writeColumn(f, cols.milli);
+    writeColumn(f, cols.raw);
+    writeColumn(f, cols.decimals);
+    writeColumn(f, cols.unit);
+    writeColumn(f, cols.battery);
+    writeColumn(f, cols.bar);
+    writeColumn(f, cols.leds);
+    writeColumn(f, cols.buzzer);
+    writeColumn(f, cols.checksumValid);
+    return fclose(f) == 0;
+}
+
+/* Expands the display frames of a trace into a packed array.
+ * Records are delta coded against the previous frame, so
+ * this part is serial.
+ */
+static bool expandTrace(const uint8_t* data, size_t len, std::vector<uint8_t>& frames, std::vector<uint32_t>& micros){
+    ProjectaTraceReader trace(data, len);
+    if(trace.begin() != PROJ_OK){
+        return false;
+    }
+    projecta_capture cap;
+    frames.reserve(len * 2);
+    while(trace.next(cap)){
+        if(cap.type == CAPTURE_FRAME && cap.length == 10){
+            frames.insert(frames.end(), cap.data, cap.data + 10);
+            micros.push_back(cap.micros);
+        }
+    }
+    if(trace.getError() != PROJ_OK){
+        fprintf(stderr, "trace damaged at offset %zu\n", trace.getPosition());
+        return false;
+    }
+    return true;
+}
+
+static int decode(const uint8_t* data, size_t len, unsigned threads, const char* csv, const char* packed){
+    std::vector<uint8_t> expanded;
+    Columns cols;
+    const uint8_t* frames = data;
+    size_t count;
+    if(len >= PROJ_TRACE_HEADER_SIZE && !memcmp(data, "PJTR", 4)){
+        uint64_t t = nowNs();
+        if(!expandTrace(data, len, expanded, cols.micros)){
+            fprintf(stderr, "not a trace\n");
+            return 1;
+        }
+        frames = expanded.data();
+        count = cols.micros.size();
+        fprintf(stderr, "trace expanded in %.1f ms\n", (nowNs() - t) / 1e6);
+    }else if(len % 10 == 0){
+        // Raw frames carry no time, the frame index stands in
+        count = len / 10;
+        cols.micros.resize(count);
+        for(size_t i=0;i<count;i++){
+            cols.micros[i] = (uint32_t)i;
+        }
+    }else{
+        fprintf(stderr, "neither a trace nor whole 10 byte frames\n");
+        return 1;
+    }
+    uint64_t t = nowNs();
+    size_t bad = decodeParallel(frames, count, cols, threads);
+    t = nowNs() - t;
+    fprintf(stderr, "%zu frames (%zu bad checksum) in %.1f ms on %u threads, %.0f frames/s\n",
+        count, bad, t / 1e6, threads, count * 1e9 / (double)(t ? t : 1));
+    if(csv && !writeCsv(csv, cols, threads)){
+        return 1;
+    }
+    if(packed && !writePacked(packed, cols)){
+        return 1;
+    }
+    return 0;
+}
+
+/* Synthetic capture: frames from the codec over every field,
+ * text frames, and one frame in 32 random bytes (mostly bad
+ * checksums and non-digit patterns)
+ */
+static void synth(std::vector<uint8_t>& frames, size_t count){
+    frames.resize(count * 10);
+    uint32_t seed = 12345;
+    for(size_t i=0;i<count;i++){
+        seed = seed * 1664525 + 1013904223;
+        uint8_t* f = &frames[i * 10];
+        uint32_t r = seed >> 8;
+        if((r & 31) == 0){
+            for(uint8_t k=0;k<10;k++){
+                seed = seed * 1664525 + 1013904223;
+                f[k] = (uint8_t)(seed >> 24);
+            }
+        }else if((r & 31) == 1){
+            memcpy(f, projectaTextFrame("Err").bytes, 10);
+        }else{
+            projecta_frame frame = projectaEncodeFrame((r >> 5) % UNIT_UNKNOWN, (int32_t)(r % 1100000) - 1000,
+                (r >> 3) % 6, (r >> 7) % 5, (r >> 11) & PROJ_LED_MASK, (r >> 17) & 1);
+            memcpy(f, frame.bytes, 10);
+        }
+    }
+}
+
+/* Compares the batch columns with projectaDecodeFrame()
+ * @returns -> mismatching frames
+ */
+static size_t verify(const uint8_t* frames, size_t count, const Columns& cols){
+    size_t mismatches = 0;
+    for(size_t i=0;i<count;i++){
+        projecta_telemetry tel;
+        projectaDecodeFrame(frames + i * 10, tel);
+        if(tel.milli != cols.milli[i] || tel.raw != cols.raw[i] || tel.decimals != cols.decimals[i] ||
+            tel.unit != cols.unit[i] || tel.battery != cols.battery[i] || tel.bar != cols.bar[i] ||
+            tel.leds != cols.leds[i] || tel.buzzer != cols.buzzer[i] || tel.checksumValid != cols.checksumValid[i]){
+            if(mismatches++ < 5){
+                fprintf(stderr, "mismatch at frame %zu\n", i);
+            }
+        }
+    }
+    return mismatches;
+}
+
+static int bench(size_t count, unsigned threads){
+    std::vector<uint8_t> frames;
+    Columns cols;
+    synth(frames, count);
+    cols.micros.resize(count);
+
+    decodeParallel(frames.data(), count, cols, threads);
+    size_t mismatches = verify(frames.data(), count, cols);
+    printf("%zu frames, %zu mismatches against projectaDecodeFrame()\n", count, mismatches);
+
+    uint64_t t = nowNs();
+    projecta_telemetry tel;
+    uint32_t sink = 0;
+    for(size_t i=0;i<count;i++){
+        projectaDecodeFrame(&frames[i * 10], tel);
+        sink += tel.milli;
+    }
+    t = nowNs() - t;
+    sinkOut = sink;
+    printf("%-34s %12.0f frames/s\n", "projectaDecodeFrame()", count * 1e9 / (double)t);
+    t = nowNs();
+    decodeParallel(frames.data(), count, cols, 1);
+    t = nowNs() - t;
+    printf("%-34s %12.0f frames/s\n", "projectaDecodeFrames(), 1 thread", count * 1e9 / (double)t);
+    t = nowNs();
+    decodeParallel(frames.data(), count, cols, threads);
+    t = nowNs() - t;
+    char name[48];
+    snprintf(name, sizeof(name), "projectaDecodeFrames(), %u threads", threads);
+    printf("%-34s %12.0f frames/s\n", name, count * 1e9 / (double)t);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        usage();
+        return 2;
+    }
+    unsigned threads = std::thread::hardware_concurrency();
+    const char* csv = NULL;
+    const char* packed = NULL;
+    const char* arg = NULL;
+    for(int i=2;i<argc;i++){
+        if(!strcmp(argv[i], "-t") && i + 1 < argc){
+            threads = (unsigned)atoi(argv[++i]);
+        }else if(!strcmp(argv[i], "-c") && i + 1 < argc){
+            csv = argv[++i];
+        }else if(!strcmp(argv[i], "-p") && i + 1 < argc){
+            packed = argv[++i];
+        }else if(!arg){
+            arg = argv[i];
+        }else{
+            usage();
+            return 2;
+        }
+    }
+    threads = threads ? threads : 1;
+    if(!strcmp(argv[1], "bench")){
+        return bench(arg ? (size_t)atol(arg) : 10000000, threads);
+    }
+    if(strcmp(argv[1], "decode") || !arg){
+        usage();
+        return 2;
+    }
+    int fd = open(arg, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0){
+        perror(arg);
+        return 1;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t* data = (const uint8_t*)(len ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : NULL);
+    if(data == MAP_FAILED){
+        perror("mmap");
+        return 1;
+    }
+    int rc = decode(data, len, threads, csv, packed);
+    if(len){
+        munmap((void*)data, len);
+    }
+    close(fd);
+    return rc;
+}
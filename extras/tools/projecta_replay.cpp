@@ -0,0 +1,211 @@
+/* Projecta trace replay tool
+ * Memory maps a ProjectaTrace file and replays it at full
+ * speed, either through the frame decoder or through the
+ * simulated bus into a Projecta object in slave mode. Can
+ * also synthesise a trace for testing. See extras/README.md
+ * for building.
+ */
+#include <Projecta.h>
+#include <ProjectaDecoder.h>
+#include <ProjectaTrace.h>
+#include <Wire.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Print adapter so ProjectaTraceWriter can write a file */
+class FilePrint : public Print{
+    private:
+        FILE* _f;
+    public:
+        FilePrint(FILE* f) : _f(f){}
+        size_t write(uint8_t c){ return fwrite(&c, 1, 1, _f); }
+        size_t write(const uint8_t* buf, size_t len){ return fwrite(buf, 1, len, _f); }
+        using Print::write;
+};
+
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void){
+    fprintf(stderr,
+        "usage: projecta_replay synth <out> [frames]   write a synthetic trace\n"
+        "       projecta_replay decode [-q] <trace>    decode frames (CSV unless -q)\n"
+        "       projecta_replay bus <trace>            replay into a slave mode Projecta\n");
+}
+
+/* A charger session: voltage ramps, buttons pressed now and
+ * then, frames at 10 Hz with mostly unchanged content
+ */
+static int synth(const char* path, uint32_t frames){
+    FILE* f = fopen(path, "wb");
+    if(!f){
+        perror(path);
+        return 1;
+    }
+    FilePrint out(f);
+    ProjectaTraceWriter trace(out);
+    SimScreen screen;
+    Wire.attachDevice(0x65, &screen);
+    Projecta proj(Wire);
+    proj.begin();
+    uint32_t t = 0;
+    trace.begin(t);
+    for(uint32_t i=0;i<frames;i++){
+        t += 100000;
+        if(i % 20 == 0){
+            proj.setVoltage_mV(12000 + (int32_t)(i % 2400));
+            proj.setBatteryBar((i / 200) % 5);
+        }
+        proj.loop();
+        trace.writeFrame(t, screen.getFrame(), 10);
+        uint8_t reply[3] = {(uint8_t)((i % 97) < 3 ? BUTTON_VOLT_AMP : 0), 0, 0};
+        trace.writeReply(t + 500, reply, 3);
+    }
+    fclose(f);
+    printf("%u frames, %zu bytes (%.2f bytes per frame + reply)\n", frames,
+        trace.getBytesWritten(), (double)trace.getBytesWritten() / frames);
+    return 0;
+}
+
+static int decode(const uint8_t* data, size_t len, bool quiet){
+    ProjectaTraceReader trace(data, len);
+    if(trace.begin() != PROJ_OK){
+        fprintf(stderr, "not a trace\n");
+        return 1;
+    }
+    projecta_capture cap;
+    projecta_telemetry tel;
+    uint32_t frames = 0, invalid = 0;
+    if(!quiet){
+        printf("micros,unit,milli,battery,bar,leds,buzzer,checksum\n");
+    }
+    uint64_t t = nowNs();
+    while(trace.next(cap)){
+        if(cap.type != CAPTURE_FRAME || cap.length != 10){
+            continue;
+        }
+        frames++;
+        if(projectaDecodeFrame(cap.data, tel) == PROJ_CHECKSUM_INVALID){
+            invalid++;
+        }
+        if(!quiet){
+            printf("%u,%u,%d,%u,%u,%u,%u,%u\n", cap.micros, tel.unit, tel.milli,
+                tel.battery, tel.bar, tel.leds, tel.buzzer, tel.checksumValid);
+        }
+    }
+    t = nowNs() - t;
+    if(trace.getError() != PROJ_OK){
+        fprintf(stderr, "trace damaged at offset %zu\n", trace.getPosition());
+        return 1;
+    }
+    fprintf(stderr, "%u frames (%u bad checksum) in %.1f ms, %.0f frames/s\n",
+        frames, invalid, t / 1e6, frames * 1e9 / (double)t);
+    return 0;
+}
+
+/* Plays the trace as a charger would: frames are written to
+ * the slave, replies are read back after loading them with
+ * setSlaveButtons(). Every capture must match the trace.
+ */
+static int bus(const uint8_t* data, size_t len){
+    ProjectaTraceReader trace(data, len);
+    if(trace.begin() != PROJ_OK){
+        fprintf(stderr, "not a trace\n");
+        return 1;
+    }
+    hostUseManualClock(true);
+    Projecta proj(Wire);
+    proj.beginSlave();
+    projecta_capture cap;
+    uint32_t records = 0, mismatches = 0;
+    uint64_t t = nowNs();
+    while(trace.next(cap)){
+        records++;
+        if(cap.type == CAPTURE_FRAME){
+            Wire.simulateMasterWrite(cap.data, cap.length);
+        }else{
+            proj.setSlaveButtons(cap.data[0]);
+            uint8_t reply[3];
+            Wire.simulateMasterRead(reply, sizeof(reply));
+        }
+        const projecta_capture* got;
+        uint8_t n = proj.getCaptures(&got);
+        if(n != 1 || got->type != cap.type || got->length != cap.length ||
+            memcmp(got->data, cap.data, cap.length) != 0){
+            if(mismatches++ < 5){
+                fprintf(stderr, "mismatch at record %u\n", records);
+            }
+        }
+        proj.releaseCaptures(n);
+    }
+    t = nowNs() - t;
+    if(trace.getError() != PROJ_OK){
+        fprintf(stderr, "trace damaged at offset %zu\n", trace.getPosition());
+        return 1;
+    }
+    printf("%u records replayed in %.1f ms, %.0f records/s, %u mismatches\n",
+        records, t / 1e6, records * 1e9 / (double)t, mismatches);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        usage();
+        return 2;
+    }
+    const char* path = NULL;
+    const char* count = NULL;
+    bool quiet = false;
+    for(int i=2;i<argc;i++){
+        if(!strcmp(argv[i], "-q")){
+            quiet = true;
+        }else if(argv[i][0] == '-' || (path && count)){
+            usage();
+            return 2;
+        }else if(!path){
+            path = argv[i];
+        }else{
+            count = argv[i];
+        }
+    }
+    if(!path){
+        usage();
+        return 2;
+    }
+    if(!strcmp(argv[1], "synth")){
+        return synth(path, count ? (uint32_t)atol(count) : 100000);
+    }
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0){
+        perror(path);
+        return 1;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t* data = (const uint8_t*)(len ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : NULL);
+    if(data == MAP_FAILED){
+        perror("mmap");
+        return 1;
+    }
+    int rc;
+    if(!strcmp(argv[1], "decode")){
+        rc = decode(data, len, quiet);
+    }else if(!strcmp(argv[1], "bus")){
+        rc = bus(data, len);
+    }else{
+        usage();
+        rc = 2;
+    }
+    if(len){
+        munmap((void*)data, len);
+    }
+    close(fd);
+    return rc;
+}
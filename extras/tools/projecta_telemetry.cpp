@@ -0,0 +1,181 @@
+/* Projecta telemetry log tool
+ * Decodes a ProjectaTelemetry log (e.g. captured from a
+ * serial port) back into the full state per frame, and
+ * benchmarks the log size against a text log and a trace
+ * for a simulated charger session, including recovery from
+ * damaged bytes. See extras/README.md for building.
+ */
+#include <ProjectaTelemetry.h>
+#include <ProjectaTrace.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define UART_BYTES_PER_S 11520  // 115200 baud, 8N1
+
+/* Print adapter collecting the output in memory */
+class BufferPrint : public Print{
+    public:
+        std::vector<uint8_t> data;
+        size_t write(uint8_t c){ data.push_back(c); return 1; }
+        size_t write(const uint8_t* buf, size_t len){ data.insert(data.end(), buf, buf + len); return len; }
+        using Print::write;
+};
+
+static void usage(void){
+    fprintf(stderr,
+        "usage: projecta_telemetry decode <log>       print the state per frame as CSV\n"
+        "       projecta_telemetry bench [frames]     size and resync check at 20 frames/s\n");
+}
+
+static void printCsv(uint32_t micros, const projecta_telemetry& tel){
+    printf("%u,%u,%d,%d,%u,%u,%u,%u,%u,%u\n", micros, tel.unit, tel.milli, tel.raw, tel.decimals,
+        tel.battery, tel.bar, tel.leds, tel.buzzer, tel.checksumValid);
+}
+
+static int decode(const uint8_t* data, size_t len){
+    ProjectaTelemetryReader log(data, len);
+    projecta_telemetry tel;
+    uint32_t micros, records = 0;
+    printf("micros,unit,milli,raw,decimals,battery,bar,leds,buzzer,checksum\n");
+    while(log.next(micros, tel)){
+        printCsv(micros, tel);
+        records++;
+    }
+    fprintf(stderr, "%u records, %u damaged, %u dropped waiting for a keyframe, %zu bytes unread\n",
+        records, log.getErrors(), log.getSkipped(), len - log.getPosition());
+    return 0;
+}
+
+/* A charger session at 20 frames/s with up to 200 us of
+ * timing jitter: voltage creeping up with some noise in the
+ * last digit, the display flipping between volts and amps
+ * every 5 s, the bar filling and the green LED flashing at
+ * 1 Hz
+ */
+static void session(uint32_t frames, std::vector<projecta_frame>& out, std::vector<uint32_t>& times){
+    uint32_t seed = 1;
+    for(uint32_t i=0;i<frames;i++){
+        seed = seed * 1664525 + 1013904223;
+        times.push_back(i * 50000 + (seed >> 8) % 200);
+        bool amps = (i / 100) & 1;
+        int32_t milli = amps ? 8000 - (int32_t)(i / 50) : 12600 + (int32_t)(i / 40) % 1800;
+        milli += (int32_t)((seed >> 24) % 3) * 10;
+        uint8_t bar = (uint8_t)((i / 3000) % 5);
+        uint8_t leds = (i / 10) & 1 ? projectaLedBit(LED_GREEN_FLASHING) : 0;
+        out.push_back(projectaEncodeFrame(amps ? UNIT_AMP : UNIT_VOLT, milli, BATTERY_AGM, bar, leds, false));
+    }
+}
+
+static bool sameState(const projecta_telemetry& a, const projecta_telemetry& b){
+    return a.milli == b.milli && a.raw == b.raw && a.decimals == b.decimals && a.unit == b.unit &&
+        a.battery == b.battery && a.bar == b.bar && a.leds == b.leds && a.buzzer == b.buzzer &&
+        a.checksumValid == b.checksumValid;
+}
+
+/* Decodes a log of the session and checks every record
+ * against the frame sent at that time
+ * @returns -> records that do not match, recovered records
+ * in *records
+ */
+static uint32_t check(ProjectaTelemetryReader& log, const std::vector<projecta_frame>& frames,
+    const std::vector<uint32_t>& times, uint32_t* records){
+    projecta_telemetry tel, want;
+    uint32_t micros, wrong = 0;
+    *records = 0;
+    while(log.next(micros, tel)){
+        uint32_t i = micros / 50000;
+        if(i >= frames.size() || times[i] != micros){
+            wrong++;
+        }else{
+            projectaDecodeFrame(frames[i].bytes, want);
+            wrong += !sameState(tel, want);
+        }
+        (*records)++;
+    }
+    return wrong;
+}
+
+static int bench(uint32_t frames){
+    std::vector<projecta_frame> sent;
+    std::vector<uint32_t> times;
+    session(frames, sent, times);
+    BufferPrint logOut, traceOut;
+    ProjectaTelemetryWriter log(logOut);
+    ProjectaTraceWriter trace(traceOut);
+    trace.begin(0);
+    size_t text = 0;
+    for(uint32_t i=0;i<frames;i++){
+        projecta_telemetry tel;
+        char line[96];
+        projectaDecodeFrame(sent[i].bytes, tel);
+        text += snprintf(line, sizeof(line), "t=%u unit=%u value=%d.%03d battery=%u bar=%u leds=%u buzzer=%u\n",
+            times[i], tel.unit, tel.milli / 1000, tel.milli % 1000, tel.battery, tel.bar, tel.leds, tel.buzzer);
+        log.writeFrame(times[i], sent[i].bytes);
+        trace.writeFrame(times[i], sent[i].bytes, 10);
+    }
+    printf("%u frames at 20 frames/s, 115200 baud carries %u bytes/s\n", frames, UART_BYTES_PER_S);
+    printf("%-22s %12s %14s %16s\n", "", "bytes/frame", "bytes/s", "max frames/s");
+    const char* names[3] = {"text per field", "ProjectaTrace", "ProjectaTelemetry"};
+    size_t sizes[3] = {text, traceOut.data.size(), logOut.data.size()};
+    for(uint8_t k=0;k<3;k++){
+        double per = (double)sizes[k] / frames;
+        printf("%-22s %12.2f %14.0f %16.0f\n", names[k], per, per * 20, UART_BYTES_PER_S / per);
+    }
+
+    uint32_t records;
+    ProjectaTelemetryReader clean(logOut.data.data(), logOut.data.size());
+    uint32_t wrong = check(clean, sent, times, &records);
+    printf("clean log: %u of %u frames rebuilt, %u wrong\n", records, frames, wrong);
+    if(wrong || records != frames){
+        return 1;
+    }
+
+    // One byte in a thousand damaged
+    std::vector<uint8_t> damaged = logOut.data;
+    uint32_t seed = 7, flips = 0;
+    for(size_t i=0;i<damaged.size();i++){
+        seed = seed * 1664525 + 1013904223;
+        if((seed >> 8) % 1000 == 0){
+            damaged[i] ^= (uint8_t)(1 << ((seed >> 4) & 7));
+            flips++;
+        }
+    }
+    ProjectaTelemetryReader noisy(damaged.data(), damaged.size());
+    wrong = check(noisy, sent, times, &records);
+    printf("damaged log (%u bit flips): %u of %u frames rebuilt, %u wrong, %u damaged records, %u dropped\n",
+        flips, records, frames, wrong, noisy.getErrors(), noisy.getSkipped());
+    return wrong ? 1 : 0;
+}
+
+int main(int argc, char** argv){
+    if(argc >= 2 && !strcmp(argv[1], "bench")){
+        return bench(argc > 2 ? (uint32_t)atol(argv[2]) : 72000);
+    }
+    if(argc < 3 || strcmp(argv[1], "decode")){
+        usage();
+        return 2;
+    }
+    int fd = open(argv[2], O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0){
+        perror(argv[2]);
+        return 1;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t* data = (const uint8_t*)(len ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : NULL);
+    if(data == MAP_FAILED){
+        perror("mmap");
+        return 1;
+    }
+    int rc = decode(data, len);
+    if(len){
+        munmap((void*)data, len);
+    }
+    close(fd);
+    return rc;
+}
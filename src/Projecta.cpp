@@ -1,35 +1,292 @@
 #include <Projecta.h>
+#include <ProjectaMux.h>
 #include <Wire.h>
+#include <ProjectaNoHeap.h>
 static uint8_t _numObjects = 0;
+static_assert(PROJECTA_MAX_SLAVES <= 4, "only 4 slave handler slots exist");
+static Projecta* _slaves[4]; // Instances listening in slave mode, by handler slot
+static const uint8_t _digitSegments[10] PROGMEM = {
+    projectaDigitSegments(0), projectaDigitSegments(1), projectaDigitSegments(2),
+    projectaDigitSegments(3), projectaDigitSegments(4), projectaDigitSegments(5),
+    projectaDigitSegments(6), projectaDigitSegments(7), projectaDigitSegments(8),
+    projectaDigitSegments(9)
+};
+static const uint8_t _glyphSegments[128] PROGMEM = { PROJ_TABLE128(projectaGlyphSegments) };
+// Bus clocks tried by autotuneClock(), slowest first
+static const uint32_t _clockRates[] PROGMEM = {100000, 200000, 400000, 1000000};
+#define PROJ_CLOCK_RATES (sizeof(_clockRates) / sizeof(_clockRates[0]))
 
-/* Constructor
+// Error names, indexed by projecta_error
+static const char _errOk[] PROGMEM = "PROJ_OK";
+static const char _errI2c[] PROGMEM = "PROJ_I2C_ERROR";
+static const char _errLimit[] PROGMEM = "PROJ_LIMIT_2_EXCEEDED";
+static const char _errBar[] PROGMEM = "PROJ_BATTERY_BAR_INVALUD";
+static const char _errBattery[] PROGMEM = "PROJ_BATTERY_TYPE_INVALID";
+static const char _errLed[] PROGMEM = "PROJ_LED_NOT_VALID";
+static const char _errTooBig[] PROGMEM = "PROJ_NUMBER_TOO_BIG";
+static const char _errChar[] PROGMEM = "PROJ_CHARACTER_INVALID";
+static const char _errChecksum[] PROGMEM = "PROJ_CHECKSUM_INVALID";
+static const char _errPage[] PROGMEM = "PROJ_PAGE_INVALID";
+static const char _errTrace[] PROGMEM = "PROJ_TRACE_INVALID";
+static const char _errField[] PROGMEM = "PROJ_FIELD_INVALID";
+static const char _errTextLong[] PROGMEM = "PROJ_TEXT_TOO_LONG";
+static const char _errUnknown[] PROGMEM = "PROJ_UNKNOWN_ERROR";
+static const char* const _errorStrings[] PROGMEM = {
+    _errOk,
+    _errI2c,
+    _errLimit,
+    _errBar,
+    _errBattery,
+    _errLed,
+    _errTooBig,
+    _errChar,
+    _errChecksum,
+    _errPage,
+    _errTrace,
+    _errField,
+    _errTextLong,
+    _errUnknown
+};
+static_assert(sizeof(_errorStrings) / sizeof(_errorStrings[0]) == PROJ_UNKNOWN_ERROR + 1, "error string table out of sync with projecta_error");
+
+/* Constructor for the legacy port assignment: the first
+ * object uses Wire and the second Wire1 (when available).
+ * Further objects have no bus and begin() reports
+ * PROJ_LIMIT_2_EXCEEDED; bind them to a bus explicitly.
  */
 Projecta::Projecta(){
     _numObjects++; // Keep track of no of objects (Max 2 i2c ports on the ESP32, 1 Master, 1 slave)
     _projNo = _numObjects;
+    switch(_projNo){
+        case 1:
+            _wire = &Wire;
+            break;
+        #ifdef MULTI_I2C
+        case 2:
+            _wire = &Wire1;
+            break;
+        #endif
+        default:
+            _wire = NULL;
+            break;
+    }
+    setButtonVoltCallback(NULL);
+    setButtonBatteryCallback(NULL);
+    setButtonChargeCallback(NULL);
+    setButtonReconditionCallback(NULL);
+}
+
+/* Constructor binding the object to any TwoWire port
+ * (hardware ports, extra ESP32 controllers, the host
+ * simulator). There is no limit on the number of objects
+ * and they do not count towards the legacy assignment.
+ */
+Projecta::Projecta(TwoWire& wire){
+    _projNo = 0; // Not part of the legacy Wire/Wire1 numbering
+    _wire = &wire;
+    setButtonVoltCallback(NULL);
+    setButtonBatteryCallback(NULL);
+    setButtonChargeCallback(NULL);
+    setButtonReconditionCallback(NULL);
+}
+
+/* Constructor for a screen behind a TCA9548A style mux:
+ * every transaction first makes sure its channel is the one
+ * connected. Any number of screens can share a bus this way.
+ */
+Projecta::Projecta(ProjectaMux& mux, uint8_t channel){
+    _projNo = 0;
+    _wire = &mux.getWire();
+    _mux = &mux;
+    _muxChannel = channel;
     setButtonVoltCallback(NULL);
     setButtonBatteryCallback(NULL);
     setButtonChargeCallback(NULL);
     setButtonReconditionCallback(NULL);
 }
 
+/* Destructor: stops the bus task and gives up the slave slot
+ */
+Projecta::~Projecta(){
+    #if PROJECTA_BUS_TASK
+    stopBusTask();
+    #endif
+    detachSlave();
+}
+
 uint8_t Projecta::getNo(){
     return _projNo;
 }
 
-/* Function to set last byte of the data to send.
- * The screen returns an error if this is not done
- * when any other byte in the send array is changed
+/* Function to change one byte of the staging frame. The
+ * checksum in byte 9 is kept up to date incrementally; the
+ * screen returns an error if it does not match.
+ * @input -> byte index (0-8) and new value
+ * @returns -> NULL
+ */
+void Projecta::setByte(uint8_t idx, uint8_t val){
+    _sendBytes[9] += val - _sendBytes[idx];
+    _sendBytes[idx] = val;
+}
+
+/* Function called by every setter once it has finished
+ * changing the staging frame. Commits it straight away
+ * unless the application has opened an update with
+ * beginUpdate().
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::frameChanged(void){
+    if(!_updating){
+        commit();
+    }
+}
+
+/* Function to start a multi-field update. Setters called
+ * until the next commit() only change the staging frame, so
+ * loop() never sends a half-updated screen.
+ * @input -> NULL
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::beginUpdate(){
+    _updating = true;
+    return *this;
+}
+
+/* Function to publish the staging frame. The staging and
+ * front frames are swapped with interrupts disabled, then the
+ * new staging frame is brought up to date from the front one.
+ * With the bus task running the frame is also posted to its
+ * mailbox and the task is woken.
  * @input -> NULL
  * @returns -> NULL
  */
-void Projecta::setLastByte(void){
-    uint8_t j=0;
-    for(int i=0;i<9;i++){
-        j += _sendBytes[i];
+void Projecta::commit(){
+    uint8_t staged = _front ^ 1;
+    noInterrupts();
+    _front = staged;
+    interrupts();
+    _sendBytes = _frames[staged ^ 1];
+    memcpy(_sendBytes, _frames[staged], 10);
+    _updating = false;
+    #if PROJECTA_BUS_TASK
+    if(_taskSlot >= 0){
+        memcpy(_mailbox.write().bytes, _frames[staged], 10);
+        _mailbox.publish();
+        wakeBusTask();
+        return;
+    }
+    #endif
+    _frameDirty = true;
+}
+
+/* Function to take a consistent copy of the front frame,
+ * safe against a commit() from an interrupt. The bus task
+ * takes it from the mailbox instead, which is safe across
+ * cores.
+ * @input -> 10 byte buffer
+ * @returns -> NULL
+ */
+void Projecta::snapshotFrame(uint8_t* frame){
+    #if PROJECTA_BUS_TASK
+    if(_taskSlot >= 0){
+        if(_mailbox.update()){
+            _frameDirty = true;
+        }
+        memcpy(frame, _mailbox.read().bytes, 10);
+        return;
+    }
+    #endif
+    noInterrupts();
+    memcpy(frame, _frames[_front], 10);
+    interrupts();
+}
+
+/* Function to decide whether the front frame has to go
+ * out on the bus. Frames are only resent when a commit has
+ * changed them since the last send, or when the refresh
+ * interval (if any) has elapsed.
+ * @input -> 10 byte buffer, filled with the frame to send
+ * @returns -> true if the frame should be written
+ */
+bool Projecta::frameDue(uint8_t* frame){
+    snapshotFrame(frame);
+    if(!_frameSentOnce){
+        return true;
+    }
+    if(_frameDirty){
+        _frameDirty = false;
+        if(memcmp(frame, _lastSentBytes, 10) != 0){
+            return true;
+        }
+    }
+    if(_refreshInterval && (uint32_t)(millis() - _lastSendMs) >= _refreshInterval){
+        return true;
+    }
+    return false;
+}
+
+/* Function to record the result of a frame write. A failed
+ * write leaves the frame dirty so the next loop retries it.
+ * @input -> the frame written, true if endTransmission() succeeded
+ * @returns -> NULL
+ */
+void Projecta::frameSent(const uint8_t* frame, bool ok){
+    if(ok){
+        memcpy(_lastSentBytes, frame, 10);
+        _lastSendMs = millis();
+        _frameSentOnce = true;
+        _framesSent++;
+    }else{
+        _frameDirty = true;
+    }
+}
+
+/* Function to check whether the committed frame still has
+ * to be written, i.e. it differs from the last frame the
+ * screen accepted (or none was accepted yet). Call from the
+ * code that runs loop()/step(), not with the bus task.
+ * @input -> NULL
+ * @returns -> true if a frame write is outstanding
+ */
+bool Projecta::isFramePending(){
+    if(!_frameSentOnce){
+        return true;
+    }
+    if(!_frameDirty){
+        return false;
     }
-    j &= 0xff;
-    _sendBytes[9] = j;
+    uint8_t frame[10];
+    getFrame(frame);
+    return memcmp(frame, _lastSentBytes, 10) != 0;
+}
+
+/* Function to set a keep-alive interval. When non-zero the
+ * current frame is resent at least this often even if
+ * nothing has changed. 0 (default) only sends on change.
+ * @input -> interval in milliseconds
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setRefreshInterval(uint32_t ms){
+    _refreshInterval = ms;
+    return *this;
+}
+
+/* Function to get the number of frames written to the screen
+ * @input -> NULL
+ * @returns -> number of frames sent
+ */
+uint32_t Projecta::getFramesSent(){
+    return _framesSent;
+}
+
+/* Function to get the number of loop() calls where the frame
+ * write was skipped because nothing had changed
+ * @input -> NULL
+ * @returns -> number of skipped sends
+ */
+uint32_t Projecta::getFramesSkipped(){
+    return _framesSkipped;
 }
 
 /* Function to clear all values from the screen
@@ -39,327 +296,1357 @@ void Projecta::setLastByte(void){
  */
 projecta_error Projecta::clearScreen(){
     for(int i=0; i<9; i++){
-        _sendBytes[i] = 0x00;
+        setByte(i, 0x00);
     }
-    setLastByte();
+    frameChanged();
     return PROJ_OK;
 }
 
 
+/* Function to set the whole frame from raw bytes, e.g. one
+ * captured from the charger. Bytes 0-8 are copied and the
+ * checksum is recomputed.
+ * @input -> 10 byte frame (byte 9 is ignored)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ */
+projecta_error Projecta::setFrame(const uint8_t* frame){
+    for(uint8_t i=0; i<9; i++){
+        setByte(i, frame[i]);
+    }
+    frameChanged();
+    return PROJ_OK;
+}
+
+/* Function to set the whole frame from one kept in flash,
+ * e.g. built at compile time with projectaTextFrame()
+ * @input -> PROGMEM frame (byte 9 is ignored)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ */
+projecta_error Projecta::setFrame_P(const projecta_frame* frame){
+    for(uint8_t i=0; i<9; i++){
+        setByte(i, pgm_read_byte(&frame->bytes[i]));
+    }
+    frameChanged();
+    return PROJ_OK;
+}
+
+/* Function to copy the last committed frame, e.g. to mirror
+ * it to other screens. Safe against a commit() from an
+ * interrupt.
+ * @input -> 10 byte buffer
+ * @returns -> NULL
+ */
+void Projecta::getFrame(uint8_t* frame){
+    noInterrupts();
+    memcpy(frame, _frames[_front], 10);
+    interrupts();
+}
+
+/* Function to check the screen answers at 0x65 after the
+ * bus has been started, and clear it
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR
+ */
+projecta_error Projecta::probeScreen(void){
+    clearScreen();
+    PROJ_STATS(_stats.transactions++;)
+    if(!selectScreen() || !addressScreen()){
+        PROJ_STATS(_stats.nacks++;)
+        linkDown();
+        return PROJ_I2C_ERROR;
+    }else{
+        __atomic_store_n(&_linkUp, true, __ATOMIC_RELEASE);
+        _linkFailures = 0;
+        return PROJ_OK;
+    }
+}
+
 /* Begin Function to Initialise the Wire library
  * and clear the screen.
  * @input -> NULL
  * @returns -> projecta_error:
  *      PROJ_OK
  *      PROJ_I2C_ERROR 
+ *      PROJ_LIMIT_2_EXCEEDED (no bus bound)
  */
 projecta_error Projecta::begin(){
     _proj_mode = PROJECTA_MASTER;
-    switch(_projNo){
-        case 1:
-            Wire.begin();
-            clearScreen();
-            Wire.beginTransmission(0x65);
-            if (Wire.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
-            }
+    if(!_wire){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    #if defined(PIN_WIRE_SDA) && defined(PIN_WIRE_SCL)
+    if(_sdaPin < 0 && _wire == &Wire){
+        setRecoveryPins(PIN_WIRE_SDA, PIN_WIRE_SCL);
+    }
+    #endif
+    _wire->begin();
+    _clockStep = -1;
+    return probeScreen();
+}
+
+#ifdef MULTI_I2C
+/* Begin Function to Initialise the Wire library
+ * and clear the screen.
+ * @input -> sda and scl pins (For espressif chips)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR 
+ *      PROJ_LIMIT_2_EXCEEDED (no bus bound)
+ */
+projecta_error Projecta::begin(int sda, int scl){
+    _proj_mode = PROJECTA_MASTER;
+    if(!_wire){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    _wire->begin(sda, scl);
+    setRecoveryPins(sda, scl);
+    _pinsFromBegin = true;
+    _busFreq = 0;
+    _clockStep = -1;
+    return probeScreen();
+}
+
+/* Begin Function to Initialise the Wire library
+ * and clear the screen.
+ * @input -> sda and scl pins (For espressif chips),
+ * i2c frequency
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR 
+ *      PROJ_LIMIT_2_EXCEEDED (no bus bound)
+ */
+projecta_error Projecta::begin(int sda, int scl, int freq){
+    _proj_mode = PROJECTA_MASTER;
+    if(!_wire){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    _wire->begin(sda, scl, freq);
+    setRecoveryPins(sda, scl);
+    _pinsFromBegin = true;
+    _busFreq = freq;
+    _clockStep = -1;
+    return probeScreen();
+}
+#endif
+
+/* Bus handlers. The Wire callbacks carry no context so each
+ * slave slot gets its own pair which forwards to the instance.
+ */
+template<uint8_t N>
+void Projecta::slaveReceiveSlot(int len){
+    if(_slaves[N]){
+        _slaves[N]->slaveReceive(len);
+    }
+}
+
+template<uint8_t N>
+void Projecta::slaveRequestSlot(void){
+    if(_slaves[N]){
+        _slaves[N]->slaveRequest();
+    }
+}
+
+/* Function to claim a slave slot and register its handlers
+ * on the bound port
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED (no bus bound or all slots taken)
+ */
+projecta_error Projecta::attachSlave(void){
+    static void (*const receiveHandlers[])(int) = {
+        slaveReceiveSlot<0>, slaveReceiveSlot<1>, slaveReceiveSlot<2>, slaveReceiveSlot<3>
+    };
+    static void (*const requestHandlers[])(void) = {
+        slaveRequestSlot<0>, slaveRequestSlot<1>, slaveRequestSlot<2>, slaveRequestSlot<3>
+    };
+    uint8_t slot;
+    for(slot=0; slot<PROJECTA_MAX_SLAVES; slot++){
+        if(_slaves[slot] == NULL || _slaves[slot] == this){
             break;
-        #ifdef MULTI_I2C
-        case 2:
-            Wire1.begin();
-            clearScreen();
-            Wire1.beginTransmission(0x65);
-            if (Wire1.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
+        }
+    }
+    if(!_wire || slot >= PROJECTA_MAX_SLAVES){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    _slaves[slot] = this;
+    _wire->onReceive(receiveHandlers[slot]);
+    _wire->onRequest(requestHandlers[slot]);
+    return PROJ_OK;
+}
+
+/* Function to give up the slave slot and unhook the bus
+ * handlers, so the bus interrupt never reaches a destroyed
+ * instance
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::detachSlave(void){
+    for(uint8_t slot=0; slot<PROJECTA_MAX_SLAVES; slot++){
+        if(_slaves[slot] == this){
+            noInterrupts();
+            _slaves[slot] = NULL;
+            interrupts();
+            _wire->onReceive(NULL);
+            _wire->onRequest(NULL);
+        }
+    }
+}
+
+/* Begin Function to listen on the bus as the screen (slave
+ * at 0x65). Every frame the charger writes and every button
+ * reply returned to it is captured into a ring buffer from
+ * the bus interrupt; drain it with getCaptures().
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED
+ */
+projecta_error Projecta::beginSlave(){
+    _proj_mode = PROJECTA_SLAVE;
+    if(!_wire){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    _wire->begin((uint8_t)0x65);
+    return attachSlave();
+}
+
+#ifdef MULTI_I2C
+/* Begin Function to listen on the bus as the screen (slave
+ * at 0x65), see beginSlave()
+ * @input -> sda and scl pins (For espressif chips)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED
+ */
+projecta_error Projecta::beginSlave(int sda, int scl){
+    _proj_mode = PROJECTA_SLAVE;
+    if(!_wire){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    #if defined(ESP8266)
+    _wire->begin(sda, scl, (uint8_t)0x65);
+    #else
+    _wire->begin((uint8_t)0x65, sda, scl, 0);
+    #endif
+    return attachSlave();
+}
+#endif
+
+/* Function run from the bus interrupt when the charger writes
+ * a frame. Stores it straight into the capture ring; when the
+ * ring is full the frame is discarded and counted as dropped.
+ * @input -> bytes received
+ * @returns -> NULL
+ */
+void Projecta::slaveReceive(int len){
+    projecta_capture* cap = _captures.reserve();
+    if(!cap){
+        while(_wire->TwoWire::available()){
+            _wire->TwoWire::read();
+        }
+        return;
+    }
+    cap->micros = micros();
+    cap->type = CAPTURE_FRAME;
+    cap->length = 0;
+    for(int i=0; i<len && _wire->TwoWire::available(); i++){
+        uint8_t b = _wire->TwoWire::read();
+        if(cap->length < sizeof(cap->data)){
+            cap->data[cap->length++] = b;
+        }
+    }
+    #if PROJECTA_STATS
+    if(cap->length == 10){
+        uint8_t sum = 0;
+        for(uint8_t i=0;i<9;i++){
+            sum += cap->data[i];
+        }
+        if(sum != cap->data[9]){
+            _stats.checksumMismatches++;
+        }
+    }
+    #endif
+    _captures.publish();
+}
+
+/* Function run from the bus interrupt when the charger reads
+ * the button state. Replies with the bytes set through
+ * setSlaveButtons() and captures the reply.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::slaveRequest(void){
+    _wire->TwoWire::write(_slaveReply, 3);
+    projecta_capture* cap = _captures.reserve();
+    if(cap){
+        cap->micros = micros();
+        cap->type = CAPTURE_REPLY;
+        cap->length = 3;
+        memcpy(cap->data, _slaveReply, 3);
+        _captures.publish();
+    }
+}
+
+/* Function to set the button byte returned to the charger
+ * in slave mode
+ * @input -> raw button bits (same layout as decodeButtons)
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setSlaveButtons(uint8_t rawBut){
+    _slaveReply[0] = rawBut;
+    return *this;
+}
+
+/* Function to set all three bytes returned to the charger
+ * in slave mode, e.g. a reply read from a real screen
+ * @input -> 3 byte reply
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setSlaveReply(const uint8_t* reply){
+    noInterrupts();
+    memcpy(_slaveReply, reply, 3);
+    interrupts();
+    return *this;
+}
+
+/* Function to get the oldest batch of captured transfers
+ * without copying. The batch stays valid until it is handed
+ * back with releaseCaptures(); call again to get the rest
+ * when the ring has wrapped.
+ * @input -> pointer set to the first capture of the batch
+ * @returns -> number of captures in the batch
+ */
+uint8_t Projecta::getCaptures(const projecta_capture** first){
+    return _captures.peek(first);
+}
+
+/* Function to release captures obtained from getCaptures()
+ * @input -> number of captures processed
+ * @returns -> NULL
+ */
+void Projecta::releaseCaptures(uint8_t count){
+    _captures.release(count);
+}
+
+/* Function to get the number of transfers lost because the
+ * capture ring was full
+ * @input -> NULL
+ * @returns -> dropped capture count
+ */
+uint16_t Projecta::getCapturesDropped(){
+    return _captures.dropped();
+}
+
+/* Function to assign a callback for link changes, called
+ * from loop()/step() when the screen stops answering and
+ * when it answers again
+ * @input -> the link callback function
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setLinkCallback(LINK_CALLBACK_SIGNATURE){
+    this->linkCallback = linkCallback;
+    return *this;
+}
+
+/* Function to set the SDA/SCL pins used by recoverBus() when
+ * the bus was started without them
+ * @input -> sda and scl pins
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setRecoveryPins(int sda, int scl){
+    _sdaPin = sda;
+    _sclPin = scl;
+    return *this;
+}
+
+/* Function to check whether the screen is answering
+ * @input -> NULL
+ * @returns -> false while the link is down
+ */
+bool Projecta::isConnected(){
+    return __atomic_load_n(&_linkUp, __ATOMIC_ACQUIRE);   // Written by the bus task
+}
+
+/* Function to connect this object's mux channel, if any,
+ * before a transaction
+ * @input -> NULL
+ * @returns -> false if the mux did not answer
+ */
+bool Projecta::selectScreen(void){
+    return !_mux || _mux->select(_muxChannel) == PROJ_OK;
+}
+
+/* Function to send an address-only probe to the screen
+ * @input -> NULL
+ * @returns -> true if the screen acknowledged
+ */
+bool Projecta::addressScreen(void){
+    _wire->beginTransmission(0x65);
+    return _wire->endTransmission() == 0;
+}
+
+/* Function to get the mux the screen sits behind
+ * @input -> NULL
+ * @returns -> mux, NULL if the screen is directly on the bus
+ */
+ProjectaMux* Projecta::getMux(){
+    return _mux;
+}
+
+/* Function to get the mux channel of the screen
+ * @input -> NULL
+ * @returns -> channel 0-7 (0 without a mux)
+ */
+uint8_t Projecta::getMuxChannel(){
+    return _muxChannel;
+}
+
+/* Function to assign a callback for the volt/amp button presses
+ * @input -> the button callback function
+ * @returns -> Null to the user
+ */
+Projecta& Projecta::setButtonVoltCallback(BUTTON_VOLT_CALLBACK_SIGNATURE){
+    this->voltCallback = voltCallback;
+    return *this;
+}
+
+/* Function to assign a callback for the battery-type button presses
+ * @input -> the button callback function
+ * @returns -> Null to the user
+ */
+Projecta& Projecta::setButtonBatteryCallback(BUTTON_BATTERY_CALLBACK_SIGNATURE){
+    this->batteryCallback = batteryCallback;
+    return *this;
+}
+
+/* Function to assign a callback for the charge-rate button presses
+ * @input -> the button callback function
+ * @returns -> Null to the user
+ */
+Projecta& Projecta::setButtonChargeCallback(BUTTON_CHARGE_CALLBACK_SIGNATURE){
+    this->chargeCallback = chargeCallback;
+    return *this;
+}
+
+/* Function to assign a callback for the recondition button presses
+ * @input -> the button callback function
+ * @returns -> Null to the user
+ */
+Projecta& Projecta::setButtonReconditionCallback(BUTTON_RECONDITION_CALLBACK_SIGNATURE){
+    this->reconditionCallback = reconditionCallback;
+    return *this;
+}
+
+/* Function to queue a button event for the application.
+ * The sequence number advances even when the queue is full,
+ * so a gap tells the reader how many events were lost.
+ * @input -> event type, button bit(s), timestamp
+ * @returns -> NULL
+ */
+void Projecta::queueButtonEvent(uint8_t type, uint8_t buttons, uint32_t at){
+    uint8_t seq = _eventSeq++;
+    projecta_button_event* ev = _buttonEvents.reserve();
+    if(ev){
+        ev->seq = seq;
+        ev->millis = at;
+        ev->type = type;
+        ev->buttons = buttons;
+        ev->held = lastButtonState;
+        _buttonEvents.publish();
+    }
+}
+
+/* Function to release every held button straight away,
+ * without the debounce, when the screen stops answering. No
+ * long press or repeat events follow for a button nobody
+ * can see.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::releaseButtons(void){
+    uint32_t now = millis();
+    memset(_receiveBytes, 0, sizeof(_receiveBytes));
+    _rawButtons = 0;
+    _rawSince = now;
+    for(uint8_t i=0;i<4;i++){
+        uint8_t bit = 1 << i;
+        if(lastButtonState & bit){
+            lastButtonState &= ~bit;
+            queueButtonEvent(EVENT_RELEASED, bit, now);
+        }
+    }
+}
+
+/* Function which debounces the button byte and queues
+ * timestamped events for every button that changed, plus
+ * long press, auto-repeat and chord events. Nothing is
+ * called back from here so bus timing does not depend on
+ * user code.
+ * @input -> byte[0] of incoming i2c data (called in loop)
+ * @returns -> NULL
+ */
+void Projecta::decodeButtons(uint8_t rawBut){
+    uint32_t now = millis();
+    rawBut &= 0x0F;
+    if(rawBut != _rawButtons){
+        _rawButtons = rawBut;
+        _rawSince = now;
+        _burstUntil = now + _burstWindowMs;
+    }
+    if(rawBut != lastButtonState && (uint32_t)(now - _rawSince) >= _debounceMs){
+        uint8_t change = rawBut ^ lastButtonState;
+        lastButtonState = rawBut;
+        for(uint8_t i=0;i<4;i++){
+            uint8_t bit = 1 << i;
+            if(change & bit){
+                if(rawBut & bit){
+                    _pressedAt[i] = _rawSince;
+                    _longSent &= ~bit;
+                    queueButtonEvent(EVENT_PRESSED, bit, _rawSince);
+                }else{
+                    queueButtonEvent(EVENT_RELEASED, bit, _rawSince);
+                }
             }
-            break;
-        #endif
-        default:
-            return PROJ_LIMIT_2_EXCEEDED;
-            break;
+        }
+        if((change & rawBut) && (rawBut & (rawBut - 1))){ // New press with 2+ buttons held
+            queueButtonEvent(EVENT_CHORD, rawBut, _rawSince);
+        }
+    }
+    if(!lastButtonState || !_longPressMs){
+        return;
+    }
+    for(uint8_t i=0;i<4;i++){
+        uint8_t bit = 1 << i;
+        if(!(lastButtonState & bit)){
+            continue;
+        }
+        if(!(_longSent & bit)){
+            if((uint32_t)(now - _pressedAt[i]) >= _longPressMs){
+                _longSent |= bit;
+                _pressedAt[i] = now; // Reused as the last repeat time
+                queueButtonEvent(EVENT_LONG_PRESS, bit, now);
+            }
+        }else if(_repeatMs && (uint32_t)(now - _pressedAt[i]) >= _repeatMs){
+            _pressedAt[i] = now;
+            queueButtonEvent(EVENT_REPEAT, bit, now);
+        }
+    }
+}
+
+/* Function to take the oldest button event from the queue
+ * @input -> event to fill in
+ * @returns -> true if an event was returned
+ */
+bool Projecta::readButtonEvent(projecta_button_event& event){
+    const projecta_button_event* first;
+    if(!_buttonEvents.peek(&first)){
+        return false;
+    }
+    event = *first;
+    _buttonEvents.release(1);
+    return true;
+}
+
+/* Function to drain the button event queue into the press and
+ * release callbacks. loop() does this after its bus work when
+ * any callback is set; with step() call it yourself.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::dispatchButtonEvents(){
+    projecta_button_event ev;
+    while(readButtonEvent(ev)){
+        if(ev.type != EVENT_PRESSED && ev.type != EVENT_RELEASED){
+            continue;
+        }
+        bool pressed = (ev.type == EVENT_PRESSED);
+        switch(ev.buttons){
+            case BUTTON_CHARGE_RATE:
+                if(chargeCallback){
+                    chargeCallback(pressed);
+                }
+                break;
+            case BUTTON_VOLT_AMP:
+                if(voltCallback){
+                    voltCallback(pressed);
+                }
+                break;
+            case BUTTON_BATTERY_TYPE:
+                if(batteryCallback){
+                    batteryCallback(pressed);
+                }
+                break;
+            case BUTTON_RECONDITION:
+                if(reconditionCallback){
+                    reconditionCallback(pressed);
+                }
+                break;
+        }
+    }
+}
+
+/* Function to set the button timings
+ * @input -> debounce time, long press time (0 = off) and
+ * auto-repeat interval after a long press (0 = off), all ms
+ * @returns -> Projecta reference for chaining
+ */
+Projecta& Projecta::setButtonTiming(uint16_t debounceMs, uint16_t longPressMs, uint16_t repeatMs){
+    _debounceMs = debounceMs;
+    _longPressMs = longPressMs;
+    _repeatMs = repeatMs;
+    return *this;
+}
+
+/* Function to get the debounced set of buttons held down
+ * @input -> NULL
+ * @returns -> projecta_button_id bits
+ */
+uint8_t Projecta::getButtons(){
+    return lastButtonState;
+}
+
+/* Function to get the last complete reply read from the
+ * screen, undebounced. All zero before the first read and
+ * while the link is down.
+ * @input -> NULL
+ * @returns -> 3 byte reply
+ */
+const uint8_t* Projecta::getReply(){
+    return _receiveBytes;
+}
+
+/* Function to get the number of button events lost because
+ * the queue was full
+ * @input -> NULL
+ * @returns -> dropped event count
+ */
+uint16_t Projecta::getButtonEventsDropped(){
+    return _buttonEvents.dropped();
+}
+
+/* Function to read the button state from the screen
+ * (one 3 byte read transaction) and decode it
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::pollButtons(void){
+    if(!_wire){
+        return;
+    }
+    PROJ_STATS_START(start);
+    uint8_t n = selectScreen() ? _wire->requestFrom(0x65,3) : 0;
+    if(n == 3){
+        for(uint8_t i=0;i<3;i++){
+            _receiveBytes[i] = _wire->TwoWire::read();
+        }
+    }
+    linkResult(n == 3);
+    PROJ_STATS(
+        _stats.transactions++;
+        if(n == 0){
+            _stats.nacks++;
+        }else if(n < 3){
+            _stats.shortReads++;
+        }
+        projectaStatsRecord(_stats.read, micros() - start);
+    )
+    if(n == 3){
+        decodeButtons(_receiveBytes[0]);
+    }
+}
+
+/* Function to write a frame to the screen
+ * (one 10 byte write transaction)
+ * @input -> the frame (from frameDue())
+ * @returns -> NULL
+ */
+void Projecta::sendFrame(const uint8_t* frame){
+    if(!_wire){
+        return;
+    }
+    #if PROJECTA_STATS
+    uint8_t sum = 0;
+    for(uint8_t i=0;i<9;i++){
+        sum += frame[i];
+    }
+    if(sum != frame[9]){
+        _stats.checksumMismatches++;
+    }
+    #endif
+    PROJ_STATS_START(start);
+    uint8_t result = 4;
+    if(selectScreen()){
+        _wire->beginTransmission(0x65);
+        _wire->TwoWire::write(frame, 10);
+        result = _wire->endTransmission();
+    }
+    linkResult(result == 0);
+    PROJ_STATS(
+        _stats.transactions++;
+        if(result){
+            _stats.nacks++;
+        }
+        projectaStatsRecord(_stats.write, micros() - start);
+    )
+    frameSent(frame, result == 0);
+}
+
+/* Function to feed the result of a read or write into the
+ * link state. PROJECTA_LINK_FAILURES failures in a row take
+ * the link down.
+ * @input -> true if the transaction succeeded
+ * @returns -> NULL
+ */
+void Projecta::linkResult(bool ok){
+    if(_clockStep > 0){
+        tuneResult(ok);
+    }
+    if(ok){
+        _linkFailures = 0;
+        return;
+    }
+    if(_mux){
+        _mux->invalidate();
+    }
+    if(_linkUp && ++_linkFailures >= PROJECTA_LINK_FAILURES){
+        linkDown();
+    }
+}
+
+/* Function to mark the link down, release any held
+ * buttons and start the probe backoff
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::linkDown(void){
+    bool wasUp = _linkUp;
+    if(_mux){
+        _mux->invalidate();
+    }
+    __atomic_store_n(&_linkUp, false, __ATOMIC_RELEASE);
+    _linkFailures = 0;
+    _tuneTransactions = 0;  // A lost screen says nothing about the clock
+    _tuneFailures = 0;
+    releaseButtons();
+    _backoffMs = PROJECTA_BACKOFF_MIN_MS;
+    _nextProbeMs = millis() + _backoffMs;
+    if(wasUp && linkCallback){
+        linkCallback(false);
+    }
+}
+
+/* Function to run the link state machine. While the link is
+ * down an address-only probe is sent each time the backoff
+ * expires, after unjamming the bus if SDA is held low. The
+ * backoff doubles on every failed probe. On reconnect the
+ * current frame is marked for an immediate resend.
+ * @input -> NULL
+ * @returns -> true if the link is up
+ */
+bool Projecta::serviceLink(void){
+    if(_linkUp){
+        return true;
+    }
+    if(!_wire || (int32_t)(millis() - _nextProbeMs) < 0){
+        return false;
+    }
+    if(_sdaPin >= 0 && digitalRead(_sdaPin) == LOW){
+        recoverBus();
+    }
+    PROJ_STATS(_stats.transactions++;)
+    if(selectScreen() && addressScreen()){
+        __atomic_store_n(&_linkUp, true, __ATOMIC_RELEASE);
+        _frameSentOnce = false;
+        if(linkCallback){
+            linkCallback(true);
+        }
+        return true;
+    }
+    PROJ_STATS(_stats.nacks++;)
+    if(_mux){
+        _mux->invalidate();
+    }
+    _backoffMs = _backoffMs >= PROJECTA_BACKOFF_MAX_MS / 2 ? PROJECTA_BACKOFF_MAX_MS : _backoffMs * 2;
+    _nextProbeMs = millis() + _backoffMs;
+    return false;
+}
+
+/* Function to free a bus held by a slave that lost sync
+ * mid-byte: clock SCL up to nine times until SDA is released,
+ * generate a STOP and restart the bus. Needs the pins, from
+ * begin(sda, scl), setRecoveryPins() or the core's default
+ * Wire pins.
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR (no pins known or SDA still held)
+ */
+projecta_error Projecta::recoverBus(){
+    if(!_wire || _sdaPin < 0 || _sclPin < 0){
+        return PROJ_I2C_ERROR;
+    }
+    #ifndef ESP8266
+    _wire->end();
+    #endif
+    pinMode(_sdaPin, INPUT_PULLUP);
+    pinMode(_sclPin, INPUT_PULLUP);
+    for(uint8_t i=0; i<9 && digitalRead(_sdaPin) == LOW; i++){
+        digitalWrite(_sclPin, LOW);
+        pinMode(_sclPin, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(_sclPin, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+    bool released = digitalRead(_sdaPin) == HIGH;
+    // STOP: SDA rises while SCL is high
+    digitalWrite(_sclPin, LOW);
+    pinMode(_sclPin, OUTPUT);
+    digitalWrite(_sdaPin, LOW);
+    pinMode(_sdaPin, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(_sclPin, INPUT_PULLUP);
+    delayMicroseconds(5);
+    pinMode(_sdaPin, INPUT_PULLUP);
+    delayMicroseconds(5);
+    restartBus();
+    return released ? PROJ_OK : PROJ_I2C_ERROR;
+}
+
+/* Function to start the bus again the way begin() did,
+ * at the autotuned clock if there is one
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::restartBus(void){
+    if(_mux){
+        _mux->invalidate();
+    }
+    #ifdef MULTI_I2C
+    if(_pinsFromBegin){
+        if(_busFreq){
+            _wire->begin(_sdaPin, _sclPin, _busFreq);
+        }else{
+            _wire->begin(_sdaPin, _sclPin);
+        }
+        applyClock();
+        return;
+    }
+    #endif
+    _wire->begin();
+    applyClock();
+}
+
+/* Function to set the bus to the autotuned clock
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::applyClock(void){
+    if(_clockStep >= 0){
+        _wire->setClock(pgm_read_dword(&_clockRates[_clockStep]));
+    }
+}
+
+/* Function to run one autotune burst: transfers frame writes
+ * each followed by a button read, at the given clock
+ * @input -> clock (Hz), transfers
+ * @returns -> true if none failed
+ */
+bool Projecta::tuneBurst(uint32_t rate, uint16_t transfers){
+    uint8_t frame[10], reply[3], last[3] = {0, 0, 0};
+    bool changed = false;
+    getFrame(frame);
+    _wire->setClock(rate);
+    for(uint16_t i=0;i<transfers;i++){
+        bool ok = selectScreen();
+        if(ok){
+            _wire->beginTransmission(0x65);
+            _wire->TwoWire::write(frame, 10);
+            ok = _wire->endTransmission() == 0;
+        }
+        ok = ok && _wire->requestFrom(0x65, 3) == 3;
+        if(ok){
+            for(uint8_t k=0;k<3;k++){
+                reply[k] = _wire->TwoWire::read();
+            }
+            // A button edge changes the reply once; a reply that
+            // changes on two reads in a row was corrupted
+            bool differs = i > 0 && memcmp(reply, last, 3) != 0;
+            ok = !(differs && changed);
+            changed = differs;
+            memcpy(last, reply, 3);
+        }
+        if(!ok){
+            if(_mux){
+                _mux->invalidate();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Function to find the fastest clock the wiring to the
+ * screen carries reliably. Steps up through 100 kHz,
+ * 200 kHz, 400 kHz and 1 MHz running a burst at each, and
+ * stops at the first rate where a write or read is NACKed,
+ * a read comes back short or the replies are corrupted.
+ * The bus is then set margin rates below the fastest that
+ * passed. From then on, PROJECTA_TUNE_MAX_FAILURES failed
+ * reads or writes within PROJECTA_TUNE_WINDOW transactions
+ * step it down one rate; it never steps back up by itself.
+ * The clock is shared by everything on the bus, so tune
+ * through the screen with the longest cable. Call after
+ * begin() and before startBusTask(); blocks for the bursts
+ * (about 0.1 s with the defaults).
+ * @input -> transfers per rate (default 32), rates to keep
+ * in hand (default 1)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR (no bus, slave mode, bus task running,
+ *      or not even 100 kHz passed, which leaves the bus at
+ *      100 kHz untuned)
+ */
+projecta_error Projecta::autotuneClock(uint16_t transfers, uint8_t margin){
+    if(!_wire || _proj_mode != PROJECTA_MASTER){
+        return PROJ_I2C_ERROR;
+    }
+    #if PROJECTA_BUS_TASK
+    if(isBusTaskRunning()){
+        return PROJ_I2C_ERROR;
+    }
+    #endif
+    int8_t best = -1;
+    for(uint8_t i=0;i<PROJ_CLOCK_RATES && tuneBurst(pgm_read_dword(&_clockRates[i]), transfers);i++){
+        best = i;
+    }
+    _tuneTransactions = 0;
+    _tuneFailures = 0;
+    _frameSentOnce = false; // A failing rate may have garbled the frame
+    if(best < 0){
+        _clockStep = -1;
+        _wire->setClock(pgm_read_dword(&_clockRates[0]));
+        return PROJ_I2C_ERROR;
+    }
+    _clockStep = best > margin ? best - margin : 0;
+    applyClock();
+    return PROJ_OK;
+}
+
+/* Function to count a transaction towards the autotune error
+ * rate, stepping the clock down when too many fail
+ * @input -> true if the transaction succeeded
+ * @returns -> NULL
+ */
+void Projecta::tuneResult(bool ok){
+    if(!ok && ++_tuneFailures >= PROJECTA_TUNE_MAX_FAILURES){
+        _clockStep--;
+        applyClock();
+        _tuneTransactions = 0;
+        _tuneFailures = 0;
+    }else if(++_tuneTransactions >= PROJECTA_TUNE_WINDOW){
+        _tuneTransactions = 0;
+        _tuneFailures = 0;
+    }
+}
+
+/* Function to get the bus clock set by this object
+ * @input -> NULL
+ * @returns -> clock (Hz) from autotuneClock() or
+ * begin(sda, scl, freq), 0 if the bus default
+ */
+uint32_t Projecta::getBusClock(){
+    return _clockStep >= 0 ? pgm_read_dword(&_clockRates[_clockStep]) : (uint32_t)_busFreq;
+}
+
+/* Function to do all bus work that is due: link probe,
+ * button read and frame write. Shared by loop() and the bus
+ * task.
+ * @input -> NULL
+ * @returns -> millis() deadline of the next bus work
+ */
+uint32_t Projecta::serviceBus(void){
+    if(serviceLink()){
+        servicePoll();
+    }
+    if(_linkUp){
+        uint8_t frame[10];
+        if(frameDue(frame)){
+            sendFrame(frame);
+        }else{
+            _framesSkipped++;
+        }
+    }
+    return busDeadline();
+}
+
+/* Loop function which user must place in the main
+ * loop of their code otherwise the i2c communication
+ * will not work. The buttons are read when the adaptive
+ * poll is due and the frame is only written when it has
+ * changed or the refresh interval has elapsed. While the
+ * link is down only the backoff probe is made. With the bus
+ * task running only the pages and callbacks are serviced.
+ * Blocks for all of its bus transactions; see step()
+ * for the non-blocking alternative.
+ * @input -> NULL
+ * @returns -> NULL
+ */ 
+void Projecta::loop(){
+    if(_proj_mode == PROJECTA_SLAVE){
+        return;
+    }
+    PROJ_STATS_START(start);
+    servicePages();
+    #if PROJECTA_BUS_TASK
+    if(_taskSlot < 0){
+        serviceBus();
+    }
+    #else
+    serviceBus();
+    #endif
+    if(voltCallback || batteryCallback || chargeCallback || reconditionCallback){
+        dispatchButtonEvents();
+    }
+    PROJ_STATS(projectaStatsRecord(_stats.loop, micros() - start);)
+}
+
+/* Cooperative alternative to loop(). Each call performs at
+ * most one bus transaction: a pending frame write takes
+ * priority, otherwise the buttons are read once the adaptive
+ * poll is due. Call it as often as convenient.
+ * @input -> NULL
+ * @returns -> millis() value by which step() should be
+ * called again (see getNextDeadline())
+ */
+uint32_t Projecta::step(){
+    uint32_t now = millis();
+    if(_proj_mode == PROJECTA_SLAVE){
+        return now + _pollIdleMs;
+    }
+    #if PROJECTA_BUS_TASK
+    if(_taskSlot >= 0){
+        servicePages();
+        return getNextDeadline();
+    }
+    #endif
+    PROJ_STATS_START(start);
+    servicePages();
+    uint8_t frame[10];
+    if(!_linkUp){
+        serviceLink();
+    }else if(frameDue(frame)){
+        sendFrame(frame);
+    }else{
+        servicePoll();
+    }
+    PROJ_STATS(projectaStatsRecord(_stats.loop, micros() - start);)
+    return getNextDeadline();
+}
+
+/* Function to get the time at which step() next has work
+ * to do, so the application can sleep or schedule other
+ * tasks until then. With the bus task running the bus work
+ * is the task's, and only the page carousel and button
+ * callbacks count (at least every idle poll interval).
+ * Call from the thread that runs loop()/step().
+ * @input -> NULL
+ * @returns -> deadline as a millis() value
+ */
+uint32_t Projecta::getNextDeadline(){
+    uint32_t deadline;
+    #if PROJECTA_BUS_TASK
+    if(_taskSlot >= 0){
+        deadline = millis() + _pollIdleMs;
+    }else{
+        deadline = busDeadline();
+    }
+    #else
+    deadline = busDeadline();
+    #endif
+    if(_pageStale){
+        return millis();
+    }
+    if(_numPages){
+        uint32_t flip = _pageSince + _pages[_page].dwell;
+        if((int32_t)(flip - deadline) < 0){
+            deadline = flip;
+        }
+    }
+    return deadline;
+}
+
+/* Function to get the time at which the bus work (probe,
+ * frame write, button read or refresh) is next due. Only the
+ * code that owns the bus calls this: step() or the bus task.
+ * @input -> NULL
+ * @returns -> deadline as a millis() value
+ */
+uint32_t Projecta::busDeadline(void){
+    if(!_linkUp){
+        return _nextProbeMs;
+    }
+    if(!_frameSentOnce || _frameDirty){
+        return millis();
+    }
+    uint32_t deadline = _nextPollMs;
+    if(_refreshInterval){
+        uint32_t refresh = _lastSendMs + _refreshInterval;
+        if((int32_t)(refresh - deadline) < 0){
+            deadline = refresh;
+        }
     }
+    return deadline;
 }
 
-#ifdef MULTI_I2C
-/* Begin Function to Initialise the Wire library
- * and clear the screen.
- * @input -> sda and scl pins (For espressif chips)
- * @returns -> projecta_error:
- *      PROJ_OK
- *      PROJ_I2C_ERROR 
+/* Function to read the buttons if the adaptive poll is due.
+ * Polling runs at the burst rate while a button is held or
+ * for the burst window after any edge, and backs off to the
+ * idle rate otherwise.
+ * @input -> NULL
+ * @returns -> true if a read was made
  */
-projecta_error Projecta::begin(int sda, int scl){
-    _proj_mode = PROJECTA_MASTER;
-    switch(_projNo){
-        case 1:
-            Wire.begin(sda, scl);
-            clearScreen();
-            Wire.beginTransmission(0x65);
-            if (Wire.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
-            }
-            break;
-        case 2:
-            Wire1.begin(sda, scl);
-            clearScreen();
-            Wire1.beginTransmission(0x65);
-            if (Wire1.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
-            }
-            break;
-        default:
-            return PROJ_LIMIT_2_EXCEEDED;
-            break;
+bool Projecta::servicePoll(void){
+    uint32_t now = millis();
+    if((int32_t)(now - _nextPollMs) < 0){
+        return false;
+    }
+    pollButtons();
+    now = millis();
+    bool burst = lastButtonState || _rawButtons != lastButtonState ||
+        (int32_t)(now - _burstUntil) < 0;
+    _nextPollMs = now + (burst ? _pollBurstMs : _pollIdleMs);
+    _pollCount++;
+    uint32_t elapsed = now - _pollRateSince;
+    if(elapsed >= 1000){
+        _pollRate = (uint16_t)((_pollCount * 1000UL + elapsed / 2) / elapsed);
+        _pollCount = 0;
+        _pollRateSince = now;
     }
+    return true;
 }
 
-/* Begin Function to Initialise the Wire library
- * and clear the screen.
- * @input -> sda and scl pins (For espressif chips),
- * i2c frequency
- * @returns -> projecta_error:
- *      PROJ_OK
- *      PROJ_I2C_ERROR 
+/* Function to set the adaptive button poll rates
+ * @input -> idle rate and burst rate in Hz (max 1000), burst
+ * window in ms kept after any button edge
+ * @returns -> Projecta reference for chaining
  */
-projecta_error Projecta::begin(int sda, int scl, int freq){
-    _proj_mode = PROJECTA_MASTER;
-    switch(_projNo){
-        case 1:
-            Wire.begin(sda, scl, freq);
-            clearScreen();
-            Wire.beginTransmission(0x65);
-            if (Wire.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
-            }
-            break;
-        case 2:
-            Wire1.begin(sda, scl, freq);
-            clearScreen();
-            Wire1.beginTransmission(0x65);
-            if (Wire1.endTransmission()){
-                return PROJ_I2C_ERROR;
-            }else{
-                return PROJ_OK;
-            }
-            break;
-        default:
-            return PROJ_LIMIT_2_EXCEEDED;
-            break;
+Projecta& Projecta::setPollRate(uint16_t idleHz, uint16_t burstHz, uint16_t burstWindowMs){
+    _pollIdleMs = idleHz ? 1000 / idleHz : 1000;
+    _pollBurstMs = burstHz ? 1000 / burstHz : 1000;
+    if(!_pollIdleMs){
+        _pollIdleMs = 1;
     }
+    if(!_pollBurstMs){
+        _pollBurstMs = 1;
+    }
+    _burstWindowMs = burstWindowMs;
+    return *this;
 }
-#endif
 
-/* Function to assign a callback for the volt/amp button presses
- * @input -> the button callback function
- * @returns -> Null to the user
+/* Function to set a fixed button poll interval (no adaptive
+ * back off)
+ * @input -> poll interval in milliseconds
+ * @returns -> Projecta reference for chaining
  */
-Projecta& Projecta::setButtonVoltCallback(BUTTON_VOLT_CALLBACK_SIGNATURE){
-    this->voltCallback = voltCallback;
+Projecta& Projecta::setPollInterval(uint32_t ms){
+    _pollIdleMs = ms;
+    _pollBurstMs = ms;
     return *this;
 }
 
-/* Function to assign a callback for the battery-type button presses
- * @input -> the button callback function
- * @returns -> Null to the user
+/* Function to get the measured button poll rate over the last
+ * second
+ * @input -> NULL
+ * @returns -> reads per second
  */
-Projecta& Projecta::setButtonBatteryCallback(BUTTON_BATTERY_CALLBACK_SIGNATURE){
-    this->batteryCallback = batteryCallback;
-    return *this;
+uint16_t Projecta::getPollRate(){
+    return _pollRate;
 }
 
-/* Function to assign a callback for the charge-rate button presses
- * @input -> the button callback function
- * @returns -> Null to the user
+#if PROJECTA_STATS
+/* Function to get the instrumentation counters and
+ * histograms (PROJECTA_STATS builds only)
+ * @input -> NULL
+ * @returns -> stats block of this object
  */
-Projecta& Projecta::setButtonChargeCallback(BUTTON_CHARGE_CALLBACK_SIGNATURE){
-    this->chargeCallback = chargeCallback;
-    return *this;
+const projecta_stats& Projecta::getStats(){
+    return _stats;
 }
 
-/* Function to assign a callback for the recondition button presses
- * @input -> the button callback function
- * @returns -> Null to the user
+/* Function to zero the instrumentation counters
+ * @input -> NULL
+ * @returns -> NULL
  */
-Projecta& Projecta::setButtonReconditionCallback(BUTTON_RECONDITION_CALLBACK_SIGNATURE){
-    this->reconditionCallback = reconditionCallback;
-    return *this;
+void Projecta::resetStats(){
+    noInterrupts();
+    memset(&_stats, 0, sizeof(_stats));
+    interrupts();
 }
 
-/* Function which decodes the button presses and returns
- * the value to the user's callback function
- * @input -> byte[0] of incoming i2c data (called in loop)
+/* Function to print the instrumentation counters and
+ * histograms. Takes a copy first so a slave interrupt
+ * cannot change it mid-print.
+ * @input -> output (e.g. Serial)
  * @returns -> NULL
  */
-void Projecta::decodeButtons(uint8_t rawBut){
-    uint8_t change = rawBut ^ lastButtonState;
-    switch(change){
-        case 0x01: // Charge rate
-            if(chargeCallback){
-                chargeCallback(rawBut & 0x01);
-            }
-            break;
-        case 0x02: // Volt amp
-            if(voltCallback){
-                voltCallback(rawBut & 0x02);
-            }
-            break;
-        case 0x04: // Battery Type
-            if(batteryCallback){
-                batteryCallback(rawBut & 0x04);
-            }
-            break;
-        case 0x08: // Recondition
-            if(reconditionCallback){
-                reconditionCallback(rawBut & 0x08);
-            }
-            break;
-    }
-    lastButtonState = rawBut;
+void Projecta::dumpStats(Print& out){
+    projecta_stats copy;
+    noInterrupts();
+    memcpy(&copy, &_stats, sizeof(copy));
+    interrupts();
+    projectaStatsDump(copy, out);
 }
+#endif
 
-/* Loop function which user must place in the main
- * loop of their code otherwise the i2c communication
- * will not work
- * @input -> NULL
+/* Function to turn a quantised value into frame bytes 1-3,
+ * the same bytes as projectaQuantisedByte() but with the
+ * flash digit table rather than a compare chain per digit
+ * @input -> projectaDigits() and projectaDecimals(),
+ * 3 byte output (frame bytes 1, 2, 3)
  * @returns -> NULL
- */ 
-void Projecta::loop(){
-    switch(_projNo){
-        case 1:
-            for(int i=0;i<5;i++){
-                Wire.requestFrom(0x65,3);
-                while(Wire.available()){
-                    Wire.readBytes(_receiveBytes,3);
-                }
-                decodeButtons(_receiveBytes[0]);
-            }
-            Wire.beginTransmission(0x65);
-            for(int i=0;i<10;i++){
-                Wire.write(_sendBytes[i]);
-            }
-            Wire.endTransmission();
-            break;
-    #ifdef MULTI_I2C
-        case 2:
-            for(int i=0;i<5;i++){
-                Wire1.requestFrom(0x65,3);
-                while(Wire1.available()){
-                    Wire1.readBytes(_receiveBytes,3);
-                }
-                decodeButtons(_receiveBytes[0]);
-            }
-            Wire1.beginTransmission(0x65);
-            for(int i=0;i<10;i++){
-                Wire1.write(_sendBytes[i]);
-            }
-            Wire1.endTransmission();
-            break;
-    #endif
-            default:
-                break;
+ */
+static void encodeQuantised(uint16_t val, uint8_t decimals, uint8_t* digits){
+    if(decimals > 2){
+        digits[0] = PROJ_SEG_DASH;
+        digits[1] = PROJ_SEG_DASH;
+        digits[2] = PROJ_SEG_DASH;
+        return;
     }
+    uint8_t h = val / 100;
+    uint8_t rem = val - h * 100;
+    uint8_t t = rem / 10;
+    uint8_t o = rem - t * 10;
+    digits[0] = pgm_read_byte(&_digitSegments[o]);
+    digits[1] = pgm_read_byte(&_digitSegments[t]) | (decimals == 1 ? PROJ_SEG_DP : 0x00);
+    digits[2] = pgm_read_byte(&_digitSegments[h]) | (decimals == 2 ? PROJ_SEG_DP : 0x00);
+}
+
+/* Function to encode a value x1000 using only integer maths
+ * (no FPU on AVR), placing the decimal point as
+ * sevenSegEncoder(double) does, see projectaDecimals().
+ * @input -> the value to be encoded x1000
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG (also for negative values)
+ */
+projecta_error Projecta::sevenSegEncoderMilli(int32_t milli){
+    return showDigits(projectaDigits(milli), projectaDecimals(milli));
 }
 
 /* Function to encode a double variable to the 3x seven segment
- * displays
+ * displays. The value is rounded once, straight to the
+ * displayed digits; a value that rounds up into the next
+ * decade moves the decimal point (9.996 shows 10.0), as
+ * projectaDecimals() does for the fixed point setters.
  * @input -> the double value to be encoded
  * @returns -> projecta_error:
  *      PROJ_OK
- *      PROJ_NUMBER_TOO_BIG
+ *      PROJ_NUMBER_TOO_BIG (also for negative values)
  */
 projecta_error Projecta::sevenSegEncoder(double val){
-    const uint8_t numbers[]={0xEB,0x60,0xC7,0xE5,0x6C,0xAD,0xAF,0xE0,0xEF,0xED};
-    int h,t,o;
-    if(val < 10){
-        val = round(val*100);
-        _sendBytes[3] = 0x10; // Decimal Place
-        _sendBytes[2] = 0x00;
-    }else if(val < 100){
-        val = round(val*10);
-        _sendBytes[3] = 0x00;
-        _sendBytes[2] = 0x10; // Decimal Place
-    }else if(val < 1000){
-        val = round(val);
-        _sendBytes[3] = 0x00;
-        _sendBytes[2] = 0x00; // Decimal Place
-    }
-    if(val < 1000){
-        h = (int)val/100;
-        t = (int)(val/10-(h*10))%10;
-        o = (int)val-h*100-t*10;
-        _sendBytes[3] |= numbers[h];
-        _sendBytes[2] |= numbers[t];
-        _sendBytes[1] = numbers[o];
-        return PROJ_OK;
-    }else{
-        _sendBytes[3] = 0x04;
-        _sendBytes[2] = 0x04;
-        _sendBytes[1] = 0x04;
-        return PROJ_NUMBER_TOO_BIG;
-    }
-    
-}
-
-projecta_error Projecta::sevenSegEncoder(char* let){
-    const uint8_t chars[] = {
-        0xEE, //a
-        0x2F, //b
-        0x8B, //c
-        0x67, //d
-        0x8F, //e
-        0x8E, //f
-        0xED, //g
-        0x2E, //h
-        0x0A, //i
-        0x63, //j
-        0x6E, //k
-        0x0B, //l
-        0xA2, //m
-        0x26, //n
-        0xEB, //o
-        0xCE, //p
-        0xEC, //q
-        0x06, //r
-        0xAD, //s
-        0x0F, //t
-        0x6B, //u
-        0x23, //v
-        0x49, //w
-        0x6E, //x
-        0x6D, //y
-        0xC7, //z
-        0x00  // space
-    };
-    char toPrint[strlen(let)];
-    for(int i=0; i<(int)strlen(let); i++){
-        if(let[i] >= 'A' && let[i] <= 'Z'){
-            toPrint[i] = let[i] + 32;
-        }else if(let[i] >= 'a' && let[i] <= 'z'){
-            toPrint[i] = let[i];
-        }else if(let[i] == ' '){ // Space
-            toPrint[i] = 0x5B;
-        }
-        else{
+    if(!(val >= 0)){
+        return showDigits(0, 3);
+    }
+    uint8_t decimals = 2;
+    double digits = round(val * 100);
+    while(digits >= 1000 && decimals){
+        decimals--;
+        digits = round(decimals ? val * 10 : val);
+    }
+    return digits >= 1000 ? showDigits(0, 3) : showDigits((uint16_t)digits, decimals);
+}
+
+/* Function to write displayed digits to frame bytes 1-3
+ * @input -> digits (0-999), decimals (0-2, 3 for dashes)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG (dashes shown)
+ */
+projecta_error Projecta::showDigits(uint16_t val, uint8_t decimals){
+    uint8_t digits[3];
+    encodeQuantised(val, decimals, digits);
+    setByte(1, digits[0]);
+    setByte(2, digits[1]);
+    setByte(3, digits[2]);
+    return decimals > 2 ? PROJ_NUMBER_TOO_BIG : PROJ_OK;
+}
+
+/* Function to show up to three characters on the display,
+ * see sevenSegEncoder(const char*, size_t)
+ * @input -> null terminated string
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHARACTER_INVALID
+ */
+projecta_error Projecta::sevenSegEncoder(const char* let){
+    return sevenSegEncoder(let, (size_t)-1);
+}
+
+/* Function to show up to three characters on the display from
+ * a bounded view of a string which need not be null
+ * terminated. Digits, letters and the punctuation in
+ * projectaSymbolSegments() are shown; a '.' lights the
+ * decimal point of the character before it, so "1.5A" fills
+ * three places. Reading stops at len, a null or once the
+ * display is full, and shorter strings are padded with
+ * spaces. Nothing is copied or allocated.
+ * @input -> characters, number of characters available
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHARACTER_INVALID (nothing is changed)
+ */
+projecta_error Projecta::sevenSegEncoder(const char* let, size_t len){
+    uint8_t seg[3] = {0x00, 0x00, 0x00}; // Blank = space
+    uint8_t n = 0;
+    for(size_t i=0; n<3 && i<len && let[i]; i++){
+        uint8_t glyph = projectaGlyph(let[i]);
+        if(glyph == PROJ_GLYPH_INVALID){
             return PROJ_CHARACTER_INVALID;
         }
+        if(glyph == PROJ_SEG_DP && n > 0 && !(seg[n - 1] & PROJ_SEG_DP)){
+            seg[n - 1] |= PROJ_SEG_DP;
+        }else{
+            seg[n++] = glyph;
+        }
     }
-    _sendBytes[1] = chars[(uint8_t)toPrint[2] - 'a'];
-    _sendBytes[2] = chars[(uint8_t)toPrint[1] - 'a'];
-    _sendBytes[3] = chars[(uint8_t)toPrint[0] - 'a'];
-    setLastByte();
+    setByte(1, seg[2] & (uint8_t)~PROJ_SEG_DP); // No decimal point on the last place
+    setByte(2, seg[1]);
+    setByte(3, seg[0]);
+    frameChanged();
     return PROJ_OK;
 }
 
+/* Function to show raw segment patterns, e.g. from
+ * projectaGlyph() or an animation, on the three places
+ * @input -> patterns from left to right
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ */
+projecta_error Projecta::setSegments(uint8_t left, uint8_t middle, uint8_t right){
+    setByte(1, right & (uint8_t)~PROJ_SEG_DP);
+    setByte(2, middle);
+    setByte(3, left);
+    frameChanged();
+    return PROJ_OK;
+}
+
+/* Function to look up the segment pattern of a character
+ * @input -> ASCII character
+ * @returns -> segment pattern, PROJ_GLYPH_INVALID if the
+ * screen cannot show it
+ */
+uint8_t projectaGlyph(char c){
+    if((uint8_t)c >= 128){
+        return PROJ_GLYPH_INVALID;
+    }
+    return pgm_read_byte(&_glyphSegments[(uint8_t)c]);
+}
+
 /* Set Voltage Function. Will update the screen
  * value with the value input and will display the
  * 'V' symbol
@@ -369,11 +1656,77 @@ projecta_error Projecta::sevenSegEncoder(char* let){
  */
 projecta_error Projecta::setVoltage(double volt){
     sevenSegEncoder(volt);
-    _sendBytes[0] = 0x08; // V
-    setLastByte();
+    setByte(0, 0x08); // V
+    frameChanged();
     return PROJ_OK;
 }
 
+/* Fixed point set value function. Updates the screen
+ * without any floating point maths. Watts and watt hours
+ * switch to kW/kWh at 1000 like setWatts()/setWh().
+ * @input -> unit to display, value x1000 (e.g. mV for volts)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setValueMilli(projecta_unit unit, int32_t milli){
+    uint8_t code = projectaValueUnitCode(unit, milli);
+    projecta_error err = sevenSegEncoderMilli(projectaScaledMilli(unit, milli));
+    setByte(0, code);
+    frameChanged();
+    return err;
+}
+
+/* Fixed point set voltage function, see setVoltage()
+ * @input -> voltage in millivolts
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setVoltage_mV(int32_t mV){
+    return setValueMilli(UNIT_VOLT, mV);
+}
+
+/* Fixed point set current function, see setCurrent()
+ * @input -> current in milliamps
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setCurrent_mA(int32_t mA){
+    return setValueMilli(UNIT_AMP, mA);
+}
+
+/* Fixed point set power function, see setWatts()
+ * @input -> power in milliwatts
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setWatts_mW(int32_t mW){
+    return setValueMilli(UNIT_WATT, mW);
+}
+
+/* Fixed point set charge function, see setAh()
+ * @input -> charge in milliamp hours
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setAh_mAh(int32_t mAh){
+    return setValueMilli(UNIT_AMP_HOUR, mAh);
+}
+
+/* Fixed point set energy function, see setWh()
+ * @input -> energy in milliwatt hours
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG
+ */
+projecta_error Projecta::setWh_mWh(int32_t mWh){
+    return setValueMilli(UNIT_WATT_HOUR, mWh);
+}
+
 /* Set Current Function. Will update the screen
  * value with the value input and will display the
  * 'A' symbol
@@ -383,8 +1736,8 @@ projecta_error Projecta::setVoltage(double volt){
  */
 projecta_error Projecta::setCurrent(double amp){
     sevenSegEncoder(amp);
-    _sendBytes[0] = 0x80; // A
-    setLastByte();
+    setByte(0, 0x80); // A
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -399,12 +1752,12 @@ projecta_error Projecta::setCurrent(double amp){
 projecta_error Projecta::setWatts(double watt){
     if(watt < 1000){
         sevenSegEncoder(watt);
-        _sendBytes[0] = 0x20; // W
+        setByte(0, 0x20); // W
     }else{
         sevenSegEncoder(watt/1000);
-        _sendBytes[0] = 0x22; // W
+        setByte(0, 0x22); // W
     }
-    setLastByte();
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -417,8 +1770,8 @@ projecta_error Projecta::setWatts(double watt){
  */
 projecta_error Projecta::setTemperature(double temp){
     sevenSegEncoder(temp);
-    _sendBytes[0] = 0x04;
-    setLastByte();
+    setByte(0, 0x04);
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -431,8 +1784,8 @@ projecta_error Projecta::setTemperature(double temp){
  */
 projecta_error Projecta::setPercent(double percent){
     sevenSegEncoder(percent);
-    _sendBytes[0] = 0x40;
-    setLastByte();
+    setByte(0, 0x40);
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -445,8 +1798,8 @@ projecta_error Projecta::setPercent(double percent){
  */
 projecta_error Projecta::setAh(double ah){
     sevenSegEncoder(ah);
-    _sendBytes[0] = 0x11;
-    setLastByte();
+    setByte(0, 0x11);
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -460,14 +1813,14 @@ projecta_error Projecta::setAh(double ah){
 projecta_error Projecta::setWh(double wh){
     if(wh < 1000){
         sevenSegEncoder(wh);
-        _sendBytes[0] = 0x30; // Wh
+        setByte(0, 0x30); // Wh
     }else{
         sevenSegEncoder(wh/1000);
-        _sendBytes[0] = 0x32; // KWh
+        setByte(0, 0x32); // KWh
     }
     // sevenSegEncoder(wh);
     // _sendBytes[0] = 0x32;
-    setLastByte();
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -480,8 +1833,8 @@ projecta_error Projecta::setWh(double wh){
  */
 projecta_error Projecta::setHours(double h){
     sevenSegEncoder(h);
-    _sendBytes[0] = 0x1;
-    setLastByte();
+    setByte(0, 0x1);
+    frameChanged();
     return PROJ_OK;    
 }
 
@@ -492,34 +1845,12 @@ projecta_error Projecta::setHours(double h){
  *      PROJ_BATTERY_TYPE_INVALID
  */
 projecta_error Projecta::setBatteryType(projecta_battery_type bat){
-    // Clear battery first (can remove this if for some reason more than 1 should be displayed)
-    _sendBytes[5] &= 0x33;
-    _sendBytes[6] &= 0xF7;
-    switch(bat){
-        case BATTERY_NONE:
-            _sendBytes[5] &= 0x33;
-            _sendBytes[6] &= 0xF7;
-            break;
-        case BATTERY_POWER_SUPPLY:
-            _sendBytes[6] |= 0x08;
-            break;
-        case BATTERY_GEL:
-            _sendBytes[5] |= 0x40;
-            break;
-        case BATTERY_AGM:
-            _sendBytes[5] |= 0x04;
-            break;
-        case BATTERY_WET:
-            _sendBytes[5] |= 0x80;
-            break;
-        case BATTERY_CALCIUM:
-            _sendBytes[5] |= 0x08;
-            break;
-        default:
-            return PROJ_BATTERY_TYPE_INVALID;
-            break;
+    if(!projectaBatteryValid(bat)){
+        return PROJ_BATTERY_TYPE_INVALID;
     }
-    setLastByte();
+    setByte(5, (_sendBytes[5] & ~PROJ_BATTERY_MASK5) | projectaBatteryByte5(bat));
+    setByte(6, (_sendBytes[6] & ~PROJ_BATTERY_MASK6) | projectaBatteryByte6(bat));
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -531,34 +1862,12 @@ projecta_error Projecta::setBatteryType(projecta_battery_type bat){
  *      PROJ_BATTERY_BAR_INVALUD
  */
 projecta_error Projecta::setBatteryBar(uint8_t batBar){
-    _sendBytes[4] &= 0x0F;
-    _sendBytes[6] &= 0xEF;
-    switch(batBar){
-        case 0:
-            _sendBytes[4] &= 0x0F;
-            _sendBytes[6] &= 0xEF;
-            break;
-        case 1:
-            _sendBytes[4] |= 0x80;
-            _sendBytes[6] |= 0x10;
-            break;
-        case 2:
-            _sendBytes[4] |= 0xC0;
-            _sendBytes[6] |= 0x10;
-            break;
-        case 3:
-            _sendBytes[4] |= 0xE0;
-            _sendBytes[6] |= 0x10;
-            break;
-        case 4:
-            _sendBytes[4] |= 0xF0;
-            _sendBytes[6] |= 0x10;
-            break;
-        default:
-            return PROJ_BATTERY_BAR_INVALUD;
-            break;
+    if(!projectaBarValid(batBar)){
+        return PROJ_BATTERY_BAR_INVALUD;
     }
-    setLastByte();
+    setByte(4, (_sendBytes[4] & ~PROJ_BAR_MASK4) | projectaBarByte4(batBar));
+    setByte(6, (_sendBytes[6] & ~PROJ_BAR_MASK6) | projectaBarByte6(batBar));
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -568,8 +1877,8 @@ projecta_error Projecta::setBatteryBar(uint8_t batBar){
  *      PROJ_OK
  */
 projecta_error Projecta::setBuzzer(bool buz){
-    _sendBytes[7] ^= (-buz ^ _sendBytes[7]) & (1 << 5);
-    setLastByte();
+    setByte(7, (_sendBytes[7] & ~PROJ_BUZZER_BIT) | (buz ? PROJ_BUZZER_BIT : 0x00));
+    frameChanged();
     return PROJ_OK;
 }
 
@@ -581,62 +1890,150 @@ projecta_error Projecta::setBuzzer(bool buz){
  *      PROJ_OK
  */
 projecta_error Projecta::setLed(projecta_led led, bool onOff){
-    // Disable Leds First
-    _sendBytes[7] &= 0xE0;
-    switch(led){
-        case LED_GREEN_RED_FLASHING:
-            _sendBytes[7] ^= (-onOff ^ _sendBytes[7]) & (1 << 4);
-            break;
-        case LED_RED_FLASHING:
-            _sendBytes[7] ^= (-onOff ^ _sendBytes[7]) & (1 << 3);
-            break;
-        case LED_SOLID_RED:
-            _sendBytes[7] ^= (-onOff ^ _sendBytes[7]) & (1 << 2);
-            break;
-        case LED_GREEN_FLASHING:
-            _sendBytes[7] ^= (-onOff ^ _sendBytes[7]) & (1 << 1);
-            break;
-        case LED_SOLID_GREEN:
-            _sendBytes[7] ^= (-onOff ^ _sendBytes[7]) & (1 << 0);
-            break;
-        default:
-            return PROJ_LED_NOT_VALID;
-            break;
+    if(!projectaLedValid(led)){
+        return PROJ_LED_NOT_VALID;
     }
-    setLastByte();
+    // Only one LED is lit at a time
+    setByte(7, (_sendBytes[7] & ~PROJ_LED_MASK) | (onOff ? projectaLedBit(led) : 0x00));
+    frameChanged();
     return PROJ_OK;
 }
 
-String Projecta::getErrorString(projecta_error err){
-    switch(err){
-        case PROJ_OK:
-            return "PROJ_OK";
-            break;
-        case PROJ_I2C_ERROR:
-            return "PROJ_I2C_ERROR";
-            break;
-        case PROJ_LIMIT_2_EXCEEDED:
-            return "PROJ_LIMIT_2_EXCEEDED";
-            break;
-        case PROJ_BATTERY_BAR_INVALUD:
-            return "PROJ_BATTERY_BAR_INVALUD";
-            break;
-        case PROJ_BATTERY_TYPE_INVALID:
-            return "PROJ_BATTERY_TYPE_INVALID";
-            break;
-        case PROJ_LED_NOT_VALID:
-            return "PROJ_LED_NOT_VALID";
-            break;
-        case PROJ_NUMBER_TOO_BIG:
-            return "PROJ_NUMBER_TOO_BIG";
-            break;
-        case PROJ_CHARACTER_INVALID:
-            return "PROJ_CHARACTER_INVALID";
-            break;
-        case PROJ_UNKNOWN_ERROR:
-            return "PROJ_UNKNOWN_ERROR";
-            break;
-        default:
-            return "PROJ_UNKNOWN_ERROR";
+/* Function to add a page to the display carousel. Pages are
+ * shown in the order added, each for its dwell time. Frames
+ * are cached per page so loop() only copies them.
+ * @input -> unit to display, value source returning the value
+ * x1000 (sampled by updatePages(), or NULL to push values with
+ * setPageValue()), dwell time in milliseconds
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_PAGE_INVALID (carousel full, see PROJECTA_MAX_PAGES)
+ */
+projecta_error Projecta::addPage(projecta_unit unit, PAGE_SOURCE_SIGNATURE, uint16_t dwell){
+    if(_numPages >= PROJECTA_MAX_PAGES){
+        return PROJ_PAGE_INVALID;
+    }
+    projecta_page& page = _pages[_numPages];
+    page.source = source;
+    page.dwell = dwell;
+    page.unit = unit;
+    page.key = 0xFFFF;
+    cachePage(page, source ? source() : 0);
+    if(_numPages++ == 0){
+        _page = 0;
+        _pageSince = millis();
+        _pageStale = true;
+    }
+    return PROJ_OK;
+}
+
+/* Function to push a new value to a page
+ * @input -> page index (order added), value x1000
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_PAGE_INVALID
+ */
+projecta_error Projecta::setPageValue(uint8_t page, int32_t milli){
+    if(page >= _numPages){
+        return PROJ_PAGE_INVALID;
+    }
+    if(cachePage(_pages[page], milli) && page == _page){
+        _pageStale = true;
+    }
+    return PROJ_OK;
+}
+
+/* Function to sample every page source and re-encode the pages
+ * whose displayed value has changed. Call it from application
+ * code at whatever rate the values change; loop() never encodes.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::updatePages(){
+    for(uint8_t i=0;i<_numPages;i++){
+        if(_pages[i].source && cachePage(_pages[i], _pages[i].source()) && i == _page){
+            _pageStale = true;
+        }
+    }
+}
+
+/* Function to remove all pages. The screen keeps showing the
+ * last page until a setter changes it.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::clearPages(){
+    _numPages = 0;
+    _page = 0;
+    _pageStale = false;
+}
+
+/* Function to get the index of the page on screen
+ * @input -> NULL
+ * @returns -> page index
+ */
+uint8_t Projecta::getPage(){
+    return _page;
+}
+
+/* Function to refresh a page's cached frame bytes. The value
+ * is quantised first and nothing is encoded unless the
+ * displayed digits or unit actually change.
+ * @input -> page, value x1000
+ * @returns -> true if the cached bytes changed
+ */
+bool Projecta::cachePage(projecta_page& page, int32_t milli){
+    uint8_t code = projectaValueUnitCode(page.unit, milli);
+    milli = projectaScaledMilli(page.unit, milli);
+    uint16_t val = projectaDigits(milli);
+    uint8_t decimals = projectaDecimals(milli);
+    uint16_t key = val | ((uint16_t)decimals << 10);
+    if(key == page.key && code == page.bytes[0]){
+        return false;
+    }
+    page.key = key;
+    page.bytes[0] = code;
+    encodeQuantised(val, decimals, &page.bytes[1]);
+    return true;
+}
+
+/* Function run from loop()/step() to rotate the carousel and
+ * put the current page's cached bytes on screen. Skipped
+ * while the application has an update open.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::servicePages(void){
+    if(!_numPages || _updating){
+        return;
+    }
+    uint32_t now = millis();
+    if((uint32_t)(now - _pageSince) >= _pages[_page].dwell){
+        if(++_page >= _numPages){
+            _page = 0;
+        }
+        _pageSince = now;
+        _pageStale = true;
+    }
+    if(_pageStale){
+        const uint8_t* bytes = _pages[_page].bytes;
+        for(uint8_t i=0;i<4;i++){
+            setByte(i, bytes[i]);
+        }
+        commit();
+        _pageStale = false;
+    }
+}
+
+/* Function to get the name of an error code. The names live
+ * in flash (PROGMEM on AVR) so nothing is allocated; the
+ * result can be passed straight to Serial.print().
+ * @input -> projecta_error
+ * @returns -> flash string with the error name
+ */
+const __FlashStringHelper* Projecta::getErrorString(projecta_error err){
+    if((unsigned)err > PROJ_UNKNOWN_ERROR){
+        err = PROJ_UNKNOWN_ERROR;
     }
-}
\ No newline at end of file
+    return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&_errorStrings[err]));
+}
@@ -6,9 +6,18 @@
 #ifndef Projecta_h
 #define Projecta_h
 #include <Arduino.h>
+#include <ProjectaConfig.h>
+#include <ProjectaCodec.h>
+#include <ProjectaMailbox.h>
+#include <ProjectaRing.h>
+#include <ProjectaSegments.h>
+#include <ProjectaStats.h>
+
+class TwoWire;
+class ProjectaMux;
 
 // Defines to determine is multi I2C ports are available
-#if defined(ESP32) || defined(ESP8266)
+#if defined(ESP32) || defined(ESP8266) || defined(PROJECTA_HOST)
 #define MULTI_I2C
 #endif
 
@@ -16,6 +25,8 @@
 #define BUTTON_BATTERY_CALLBACK_SIGNATURE void (*batteryCallback)(bool pressed)   // Function Callback Definition
 #define BUTTON_CHARGE_CALLBACK_SIGNATURE void (*chargeCallback)(bool pressed)   // Function Callback Definition
 #define BUTTON_RECONDITION_CALLBACK_SIGNATURE void (*reconditionCallback)(bool pressed)   // Function Callback Definition
+#define PAGE_SOURCE_SIGNATURE int32_t (*source)(void)   // Page value x1000
+#define LINK_CALLBACK_SIGNATURE void (*linkCallback)(bool connected)   // Function Callback Definition
 
 typedef enum{
     PROJ_OK,
@@ -26,6 +37,11 @@ typedef enum{
     PROJ_LED_NOT_VALID,
     PROJ_NUMBER_TOO_BIG,
     PROJ_CHARACTER_INVALID,
+    PROJ_CHECKSUM_INVALID,
+    PROJ_PAGE_INVALID,
+    PROJ_TRACE_INVALID,
+    PROJ_FIELD_INVALID,
+    PROJ_TEXT_TOO_LONG,
     PROJ_UNKNOWN_ERROR
 }projecta_error;
 
@@ -41,54 +57,201 @@ typedef enum{
 }projecta_button;
 
 typedef enum{
-    BATTERY_NONE = 0,
-    BATTERY_POWER_SUPPLY,
-    BATTERY_GEL,
-    BATTERY_AGM,
-    BATTERY_WET,
-    BATTERY_CALCIUM
-}projecta_battery_type;
+    BUTTON_CHARGE_RATE = 0x01,
+    BUTTON_VOLT_AMP = 0x02,
+    BUTTON_BATTERY_TYPE = 0x04,
+    BUTTON_RECONDITION = 0x08
+}projecta_button_id;
 
 typedef enum{
-    LED_GREEN_RED_FLASHING = 0,
-    LED_RED_FLASHING,
-    LED_SOLID_RED,
-    LED_GREEN_FLASHING,
-    LED_SOLID_GREEN
-}projecta_led;
+    EVENT_PRESSED = 0,
+    EVENT_RELEASED,
+    EVENT_LONG_PRESS,   // Held for the long press time
+    EVENT_REPEAT,       // Auto-repeat while still held after a long press
+    EVENT_CHORD         // A press left 2+ buttons held; buttons = all held
+}projecta_event_type;
+
+typedef struct{
+    uint32_t millis;    // millis() of the edge
+    uint8_t type;       // projecta_event_type
+    uint8_t buttons;    // projecta_button_id bit(s) the event is for
+    uint8_t held;       // all buttons held after the event
+    uint8_t seq;        // counts every event, dropped ones too
+}projecta_button_event;
 
 typedef enum{
     PROJECTA_SLAVE = 0,
     PROJECTA_MASTER
 }projecta_mode;
 
+typedef enum{
+    CAPTURE_FRAME = 0,  // charger -> screen display frame
+    CAPTURE_REPLY       // screen -> charger button reply
+}projecta_capture_type;
+
+typedef struct{
+    uint32_t micros;    // micros() when the transfer completed
+    uint8_t type;       // projecta_capture_type
+    uint8_t length;     // valid bytes in data
+    uint8_t data[10];
+}projecta_capture;
+
+typedef struct{
+    PAGE_SOURCE_SIGNATURE;  // NULL if the value is set with setPageValue()
+    uint16_t dwell;         // ms the page stays on screen
+    uint8_t unit;           // projecta_unit
+    uint16_t key;           // quantised value the cached bytes show
+    uint8_t bytes[4];       // cached frame bytes 0-3
+}projecta_page;
+
 class Projecta{
     private:
-        void setLastByte(void);
+        void setByte(uint8_t idx, uint8_t val);
+        void frameChanged(void);
+        void snapshotFrame(uint8_t* frame);
         void decodeButtons(uint8_t rawBut);
+        void releaseButtons(void);
         projecta_error sevenSegEncoder(double);
-        uint8_t _sendBytes[10];
-        uint8_t _receiveBytes[3];
+        projecta_error sevenSegEncoderMilli(int32_t);
+        projecta_error showDigits(uint16_t val, uint8_t decimals);
+        uint8_t _frames[2][10] = {{0}, {0}}; // Front frame (sent by loop()) and staging frame
+        uint8_t _front = 0;
+        uint8_t* _sendBytes = _frames[1]; // Staging frame written by the setters
+        bool _updating = false;
+        projecta_page _pages[PROJECTA_MAX_PAGES];
+        uint8_t _numPages = 0;
+        uint8_t _page = 0;
+        uint32_t _pageSince = 0;
+        bool _pageStale = false;
+        bool cachePage(projecta_page& page, int32_t milli);
+        void servicePages(void);
+        uint8_t _receiveBytes[3] = {0, 0, 0};   // Last complete reply
         BUTTON_VOLT_CALLBACK_SIGNATURE;
         BUTTON_BATTERY_CALLBACK_SIGNATURE;
         BUTTON_CHARGE_CALLBACK_SIGNATURE;
         BUTTON_RECONDITION_CALLBACK_SIGNATURE;
-        uint8_t lastButtonState = 0;
+        uint8_t lastButtonState = 0; // Debounced
+        uint8_t _rawButtons = 0;
+        uint32_t _rawSince = 0;
+        uint32_t _pressedAt[4];
+        uint8_t _longSent = 0;
+        uint16_t _debounceMs = 20;
+        uint16_t _longPressMs = 800;
+        uint16_t _repeatMs = 0;
+        ProjectaRing<projecta_button_event, PROJECTA_EVENT_SLOTS> _buttonEvents;
+        void queueButtonEvent(uint8_t type, uint8_t buttons, uint32_t at);
+        uint8_t _eventSeq = 0;
         static const uint8_t numberDecodeArray[9][7];
         uint8_t _projNo; // Store the _numObjects val in here when instantiated
-        projecta_mode _proj_mode;
+        projecta_mode _proj_mode = PROJECTA_MASTER;
+        bool frameDue(uint8_t* frame);
+        void frameSent(const uint8_t* frame, bool ok);
+        void pollButtons(void);
+        void sendFrame(const uint8_t* frame);
+        uint8_t _lastSentBytes[10];
+        bool _frameDirty = true;
+        bool _frameSentOnce = false;
+        uint32_t _refreshInterval = 0; // ms, 0 = only send when the frame changes
+        uint32_t _lastSendMs = 0;
+        uint32_t _framesSent = 0;
+        uint32_t _framesSkipped = 0;
+        uint32_t _pollIdleMs = 50;   // ms between button reads when idle
+        uint32_t _pollBurstMs = 5;   // ms between button reads after an edge
+        uint16_t _burstWindowMs = 2000;
+        uint32_t _burstUntil = 0;
+        uint32_t _nextPollMs = 0;
+        uint32_t _pollCount = 0;
+        uint32_t _pollRateSince = 0;
+        uint16_t _pollRate = 0;
+        bool servicePoll(void);
+        uint32_t serviceBus(void);
+        uint32_t busDeadline(void);
+        #if PROJECTA_BUS_TASK
+        ProjectaMailbox<projecta_frame> _mailbox;   // frames from commit() to the task
+        int8_t _taskSlot = -1;
+        volatile bool _taskRun = false;
+        void wakeBusTask(void);
+        static void busTaskMain(void* arg);
+        #endif
+        #if PROJECTA_STATS
+        projecta_stats _stats = {};
+        #endif
+        ProjectaRing<projecta_capture, PROJECTA_CAPTURE_SLOTS> _captures;
+        uint8_t _slaveReply[3] = {0, 0, 0};
+        TwoWire* _wire;
+        ProjectaMux* _mux = NULL;   // NULL = screen directly on the bus
+        uint8_t _muxChannel = 0;
+        bool selectScreen(void);
+        bool addressScreen(void);
+        int8_t _sdaPin = -1;    // kept for bus recovery
+        int8_t _sclPin = -1;
+        bool _pinsFromBegin = false;
+        int32_t _busFreq = 0;   // 0 = bus default
+        int8_t _clockStep = -1; // autotuned rate index, -1 = not tuned
+        uint16_t _tuneTransactions = 0;
+        uint8_t _tuneFailures = 0;
+        bool tuneBurst(uint32_t rate, uint16_t transfers);
+        void tuneResult(bool ok);
+        void applyClock(void);
+        bool _linkUp = true;
+        uint8_t _linkFailures = 0;
+        uint16_t _backoffMs = 0;
+        uint32_t _nextProbeMs = 0;
+        LINK_CALLBACK_SIGNATURE = NULL;
+        void linkResult(bool ok);
+        void linkDown(void);
+        bool serviceLink(void);
+        void restartBus(void);
+        projecta_error probeScreen(void);
+        projecta_error attachSlave(void);
+        void detachSlave(void);
+        void slaveReceive(int len);
+        void slaveRequest(void);
+        template<uint8_t N> static void slaveReceiveSlot(int len);
+        template<uint8_t N> static void slaveRequestSlot(void);
     public:
         Projecta();
+        Projecta(TwoWire& wire);
+        Projecta(ProjectaMux& mux, uint8_t channel);
+        ~Projecta();
         projecta_error begin();
         #ifdef MULTI_I2C
         projecta_error begin(int sda, int scl);
         projecta_error begin(int sda, int scl, int freq);
         #endif
+        projecta_error beginSlave();
+        #ifdef MULTI_I2C
+        projecta_error beginSlave(int sda, int scl);
+        #endif
+        Projecta& setSlaveButtons(uint8_t rawBut);
+        Projecta& setSlaveReply(const uint8_t* reply);
+        uint8_t getCaptures(const projecta_capture** first);
+        void releaseCaptures(uint8_t count);
+        uint16_t getCapturesDropped();
         Projecta& setButtonVoltCallback(BUTTON_VOLT_CALLBACK_SIGNATURE);
         Projecta& setButtonBatteryCallback(BUTTON_BATTERY_CALLBACK_SIGNATURE);
         Projecta& setButtonChargeCallback(BUTTON_CHARGE_CALLBACK_SIGNATURE);
         Projecta& setButtonReconditionCallback(BUTTON_RECONDITION_CALLBACK_SIGNATURE);
+        Projecta& setButtonTiming(uint16_t debounceMs, uint16_t longPressMs, uint16_t repeatMs);
+        bool readButtonEvent(projecta_button_event& event);
+        void dispatchButtonEvents();
+        uint8_t getButtons();
+        const uint8_t* getReply();
+        uint16_t getButtonEventsDropped();
+        Projecta& setLinkCallback(LINK_CALLBACK_SIGNATURE);
+        Projecta& setRecoveryPins(int sda, int scl);
+        bool isConnected();
+        ProjectaMux* getMux();
+        uint8_t getMuxChannel();
+        projecta_error recoverBus();
+        projecta_error autotuneClock(uint16_t transfers = 32, uint8_t margin = 1);
+        uint32_t getBusClock();
         projecta_error clearScreen();
+        projecta_error setFrame(const uint8_t* frame);
+        projecta_error setFrame_P(const projecta_frame* frame);
+        void getFrame(uint8_t* frame);
+        Projecta& beginUpdate();
+        void commit();
         projecta_error setVoltage(double);
         projecta_error setCurrent(double);
         projecta_error setWatts(double);
@@ -97,16 +260,50 @@ class Projecta{
         projecta_error setAh(double);
         projecta_error setWh(double);
         projecta_error setHours(double);
+        projecta_error setValueMilli(projecta_unit, int32_t);
+        projecta_error setVoltage_mV(int32_t);
+        projecta_error setCurrent_mA(int32_t);
+        projecta_error setWatts_mW(int32_t);
+        projecta_error setAh_mAh(int32_t);
+        projecta_error setWh_mWh(int32_t);
         projecta_error setBatteryType(projecta_battery_type);
         projecta_error setBatteryBar(uint8_t);
         projecta_error setBuzzer(bool);
         projecta_error setLed(projecta_led, bool);
-        String getErrorString(projecta_error);
+        projecta_error addPage(projecta_unit unit, PAGE_SOURCE_SIGNATURE, uint16_t dwell);
+        projecta_error setPageValue(uint8_t page, int32_t milli);
+        void updatePages();
+        void clearPages();
+        uint8_t getPage();
+        const __FlashStringHelper* getErrorString(projecta_error);
+        Projecta& setRefreshInterval(uint32_t ms);
+        uint32_t getFramesSent();
+        uint32_t getFramesSkipped();
+        bool isFramePending();
+        Projecta& setPollInterval(uint32_t ms);
+        Projecta& setPollRate(uint16_t idleHz, uint16_t burstHz, uint16_t burstWindowMs);
+        uint16_t getPollRate();
+        #if PROJECTA_STATS
+        const projecta_stats& getStats();
+        void resetStats();
+        void dumpStats(Print& out);
+        #endif
+        #if PROJECTA_BUS_TASK
+        projecta_error startBusTask(uint8_t core = 1, uint8_t priority = 2);
+        void stopBusTask();
+        bool isBusTaskRunning();
+        #endif
         void loop();
+        uint32_t step();
+        uint32_t getNextDeadline();
 
         uint8_t getNo();
 
-        projecta_error sevenSegEncoder(char*); //
+        projecta_error sevenSegEncoder(const char*);
+        projecta_error sevenSegEncoder(const char*, size_t);
+        projecta_error setSegments(uint8_t left, uint8_t middle, uint8_t right);
 };
 
+uint8_t projectaGlyph(char c);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,205 @@
+/* Projecta Library - Ben Soutter 2018
+ * Frame codec: value, unit, battery type, bar, LEDs and
+ * buzzer -> the 10 byte display frame. Everything here is
+ * constexpr and needs nothing from Arduino.h, so fixed
+ * screens ("Err", "---", a startup splash) can be built at
+ * compile time and kept in flash, and the same code runs on
+ * the host. The Projecta setters are thin wrappers that only
+ * change the bits each field owns in the staging frame.
+ *
+ * Frame layout:
+ *      byte 0      unit symbol
+ *      bytes 1-3   digits, right to left (DP on 2 and 3)
+ *      byte 4      battery bar (top nibble)
+ *      byte 5      battery type
+ *      byte 6      power supply and bar enable
+ *      byte 7      LEDs (bits 0-4) and buzzer (bit 5)
+ *      byte 9      checksum, sum of bytes 0-8
+ */
+#ifndef ProjectaCodec_h
+#define ProjectaCodec_h
+#include <stdint.h>
+#include <ProjectaSegments.h>
+
+typedef enum{
+    BATTERY_NONE = 0,
+    BATTERY_POWER_SUPPLY,
+    BATTERY_GEL,
+    BATTERY_AGM,
+    BATTERY_WET,
+    BATTERY_CALCIUM
+}projecta_battery_type;
+
+typedef enum{
+    LED_GREEN_RED_FLASHING = 0,
+    LED_RED_FLASHING,
+    LED_SOLID_RED,
+    LED_GREEN_FLASHING,
+    LED_SOLID_GREEN
+}projecta_led;
+
+typedef struct{
+    uint8_t bytes[10];
+}projecta_frame;
+
+// Bits of the frame each field owns
+#define PROJ_BAR_MASK4 0xF0
+#define PROJ_BAR_MASK6 0x10
+#define PROJ_BATTERY_MASK5 0xCC
+#define PROJ_BATTERY_MASK6 0x08
+#define PROJ_LED_MASK 0x1F
+#define PROJ_BUZZER_BIT 0x20
+
+/* Value x1000 -> digits after the decimal point (0-2), 3 if
+ * it does not fit (also for negative values). A value that
+ * rounds up into the next decade moves the decimal point
+ * rather than overflowing (9.996 shows 10.0), as the double
+ * setters do.
+ */
+constexpr uint8_t projectaDecimals(int32_t milli){
+    return milli < 0 || milli >= 999500 ? 3 : milli < 9995 ? 2 : milli < 99950 ? 1 : 0;
+}
+
+/* Value x1000 -> displayed digits as an integer (0-999), 0 if
+ * it does not fit
+ */
+constexpr uint16_t projectaDigits(int32_t milli){
+    return projectaDecimals(milli) == 3 ? 0 :
+           projectaDecimals(milli) == 2 ? (uint16_t)((milli + 5) / 10) :
+           projectaDecimals(milli) == 1 ? (uint16_t)((milli + 50) / 100) :
+           (uint16_t)((milli + 500) / 1000);
+}
+
+/* Displayed digits and decimals -> frame byte 1, 2 or 3, all
+ * dashes if the value does not fit
+ */
+constexpr uint8_t projectaQuantisedByte(uint16_t val, uint8_t decimals, uint8_t idx){
+    return decimals > 2 ? PROJ_SEG_DASH :
+           (uint8_t)(projectaDigitSegments(idx == 1 ? val % 10 : idx == 2 ? val / 10 % 10 : val / 100) |
+           (decimals != 0 && decimals == idx - 1 ? PROJ_SEG_DP : 0x00));
+}
+
+/* Watts and watt hours switch to kW/kWh at 1000 */
+constexpr bool projectaKilo(uint8_t unit, int32_t milli){
+    return (unit == UNIT_WATT || unit == UNIT_WATT_HOUR) && milli >= 1000000;
+}
+
+/* projecta_unit and value x1000 -> frame byte 0 */
+constexpr uint8_t projectaValueUnitCode(uint8_t unit, int32_t milli){
+    return !projectaKilo(unit, milli) ? projectaUnitCode(unit) :
+           unit == UNIT_WATT ? PROJ_UNIT_CODE_KILOWATT : PROJ_UNIT_CODE_KILOWATT_HOUR;
+}
+
+/* Value x1000 rescaled for the unit projectaValueUnitCode() picks */
+constexpr int32_t projectaScaledMilli(uint8_t unit, int32_t milli){
+    return projectaKilo(unit, milli) ? milli / 1000 : milli;
+}
+
+/* projecta_unit and value x1000 -> frame byte 1, 2 or 3 */
+constexpr uint8_t projectaValueByte(uint8_t unit, int32_t milli, uint8_t idx){
+    return projectaQuantisedByte(projectaDigits(projectaScaledMilli(unit, milli)),
+                                 projectaDecimals(projectaScaledMilli(unit, milli)), idx);
+}
+
+constexpr bool projectaBatteryValid(uint8_t bat){
+    return bat <= BATTERY_CALCIUM;
+}
+
+/* projecta_battery_type -> its bits of frame byte 5 */
+constexpr uint8_t projectaBatteryByte5(uint8_t bat){
+    return bat == BATTERY_GEL ? 0x40 : bat == BATTERY_AGM ? 0x04 :
+           bat == BATTERY_WET ? 0x80 : bat == BATTERY_CALCIUM ? 0x08 : 0x00;
+}
+
+/* projecta_battery_type -> its bits of frame byte 6 */
+constexpr uint8_t projectaBatteryByte6(uint8_t bat){
+    return bat == BATTERY_POWER_SUPPLY ? 0x08 : 0x00;
+}
+
+constexpr bool projectaBarValid(uint8_t bar){
+    return bar <= 4;
+}
+
+/* Bar level (0-4) -> its bits of frame byte 4, filling from bit 7 */
+constexpr uint8_t projectaBarByte4(uint8_t bar){
+    return bar >= 1 && bar <= 4 ? (uint8_t)(0xF0 << (4 - bar)) : 0x00;
+}
+
+/* Bar level (0-4) -> its bits of frame byte 6 */
+constexpr uint8_t projectaBarByte6(uint8_t bar){
+    return bar >= 1 && bar <= 4 ? 0x10 : 0x00;
+}
+
+constexpr bool projectaLedValid(uint8_t led){
+    return led <= LED_SOLID_GREEN;
+}
+
+/* projecta_led -> its bit of frame byte 7 */
+constexpr uint8_t projectaLedBit(uint8_t led){
+    return projectaLedValid(led) ? (uint8_t)(1 << (4 - led)) : 0x00;
+}
+
+constexpr uint8_t projectaChecksum(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4,
+                                   uint8_t b5, uint8_t b6, uint8_t b7, uint8_t b8){
+    return (uint8_t)(b0 + b1 + b2 + b3 + b4 + b5 + b6 + b7 + b8);
+}
+
+/* Bytes 0-8 -> complete frame with its checksum */
+constexpr projecta_frame projectaMakeFrame(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4,
+                                           uint8_t b5, uint8_t b6, uint8_t b7, uint8_t b8){
+    return projecta_frame{{b0, b1, b2, b3, b4, b5, b6, b7, b8,
+                           projectaChecksum(b0, b1, b2, b3, b4, b5, b6, b7, b8)}};
+}
+
+/* Every field -> complete frame, the same bytes the setters
+ * leave in the staging frame
+ * @input -> projecta_unit, value x1000, projecta_battery_type,
+ * bar level, LED bits (bit n = projecta_led (4 - n), as in
+ * projecta_telemetry), buzzer
+ */
+constexpr projecta_frame projectaEncodeFrame(uint8_t unit, int32_t milli, uint8_t battery = BATTERY_NONE,
+                                             uint8_t bar = 0, uint8_t leds = 0, bool buzzer = false){
+    return projectaMakeFrame(projectaValueUnitCode(unit, milli),
+                             projectaValueByte(unit, milli, 1),
+                             projectaValueByte(unit, milli, 2),
+                             projectaValueByte(unit, milli, 3),
+                             projectaBarByte4(bar),
+                             projectaBatteryByte5(battery),
+                             (uint8_t)(projectaBatteryByte6(battery) | projectaBarByte6(bar)),
+                             (uint8_t)((leds & PROJ_LED_MASK) | (buzzer ? PROJ_BUZZER_BIT : 0x00)),
+                             0x00);
+}
+
+/* Character i of a string, 0 past its end */
+constexpr uint8_t projectaTextChar(const char* text, uint8_t i){
+    return !text[0] ? 0 : i == 0 ? (uint8_t)text[0] : projectaTextChar(text + 1, i - 1);
+}
+
+/* Glyph of a text character, a space past the end */
+constexpr uint8_t projectaTextGlyph(const char* text, uint8_t i){
+    return projectaTextChar(text, i) ? projectaGlyphSegments(projectaTextChar(text, i)) : 0x00;
+}
+
+/* True if the first three characters of a string all have a
+ * glyph, for static_assert() next to projectaTextFrame()
+ */
+constexpr bool projectaTextValid(const char* text){
+    return projectaTextGlyph(text, 0) != PROJ_GLYPH_INVALID &&
+           projectaTextGlyph(text, 1) != PROJ_GLYPH_INVALID &&
+           projectaTextGlyph(text, 2) != PROJ_GLYPH_INVALID;
+}
+
+/* Up to three characters -> complete frame, one character per
+ * place (a '.' takes a place of its own here, unlike
+ * sevenSegEncoder())
+ * @input -> text, frame byte 0 (e.g. PROJ_UNIT_CODE_VOLT)
+ */
+constexpr projecta_frame projectaTextFrame(const char* text, uint8_t unitCode = 0x00){
+    return projectaMakeFrame(unitCode,
+                             (uint8_t)(projectaTextGlyph(text, 2) & ~PROJ_SEG_DP),
+                             projectaTextGlyph(text, 1),
+                             projectaTextGlyph(text, 0),
+                             0x00, 0x00, 0x00, 0x00, 0x00);
+}
+
+#endif
@@ -0,0 +1,131 @@
+/* Projecta Library configuration
+ * Compile-time sizes and feature switches. Each can be
+ * overridden with a build flag (e.g. -DPROJECTA_CAPTURE_SLOTS=32).
+ */
+#ifndef ProjectaConfig_h
+#define ProjectaConfig_h
+
+// Number of captured bus transfers buffered in slave mode.
+// Must be a power of two no larger than 128.
+#ifndef PROJECTA_CAPTURE_SLOTS
+#if defined(__AVR__)
+#define PROJECTA_CAPTURE_SLOTS 8
+#else
+#define PROJECTA_CAPTURE_SLOTS 32
+#endif
+#endif
+
+// Number of pages the display carousel can hold
+#ifndef PROJECTA_MAX_PAGES
+#define PROJECTA_MAX_PAGES 6
+#endif
+
+// Number of objects that can listen in slave mode at once (max 4),
+// a slot is freed when its object is destroyed
+#ifndef PROJECTA_MAX_SLAVES
+#define PROJECTA_MAX_SLAVES 2
+#endif
+
+// Number of button events queued for the application.
+// Must be a power of two no larger than 128.
+#ifndef PROJECTA_EVENT_SLOTS
+#if defined(__AVR__)
+#define PROJECTA_EVENT_SLOTS 8
+#else
+#define PROJECTA_EVENT_SLOTS 16
+#endif
+#endif
+
+// Per object bus counters and latency histograms (see
+// ProjectaStats.h). 0 compiles all of it out.
+#ifndef PROJECTA_STATS
+#define PROJECTA_STATS 0
+#endif
+
+// Number of log2 latency buckets per histogram when
+// PROJECTA_STATS is enabled. The last bucket collects
+// everything from 2^(n-2) us upwards.
+#ifndef PROJECTA_STATS_BUCKETS
+#define PROJECTA_STATS_BUCKETS 16
+#endif
+
+// Consecutive failed transactions before the link to the
+// screen is declared down
+#ifndef PROJECTA_LINK_FAILURES
+#define PROJECTA_LINK_FAILURES 3
+#endif
+
+// Probe interval while the link is down, doubling from the
+// minimum to the maximum (ms)
+#ifndef PROJECTA_BACKOFF_MIN_MS
+#define PROJECTA_BACKOFF_MIN_MS 10
+#endif
+#ifndef PROJECTA_BACKOFF_MAX_MS
+#define PROJECTA_BACKOFF_MAX_MS 1000
+#endif
+
+// Clock autotune (autotuneClock()): this many failed reads
+// and writes within a window of transactions steps the bus
+// down one rate
+#ifndef PROJECTA_TUNE_MAX_FAILURES
+#define PROJECTA_TUNE_MAX_FAILURES 4
+#endif
+#ifndef PROJECTA_TUNE_WINDOW
+#define PROJECTA_TUNE_WINDOW 256
+#endif
+
+// Dedicated bus task (startBusTask()): a pinned FreeRTOS
+// task on ESP32, a std::thread on the host build
+#ifndef PROJECTA_BUS_TASK
+#if defined(ESP32) || defined(PROJECTA_HOST)
+#define PROJECTA_BUS_TASK 1
+#else
+#define PROJECTA_BUS_TASK 0
+#endif
+#endif
+
+// Number of objects that can run a bus task at once, and the
+// stack of each task (bytes on ESP32)
+#ifndef PROJECTA_MAX_TASKS
+#define PROJECTA_MAX_TASKS 2
+#endif
+#ifndef PROJECTA_TASK_STACK
+#define PROJECTA_TASK_STACK 3072
+#endif
+
+// Longest message ProjectaMarquee can hold, in displayed
+// places (a '.' folded into the place before it is free)
+#ifndef PROJECTA_MARQUEE_LEN
+#if defined(__AVR__)
+#define PROJECTA_MARQUEE_LEN 32
+#else
+#define PROJECTA_MARQUEE_LEN 128
+#endif
+#endif
+
+// ProjectaEnergy holds the last voltage and current for at
+// most this long between samples; longer gaps are not
+// integrated (ms, at most 2000)
+#ifndef PROJECTA_ENERGY_MAX_GAP_MS
+#define PROJECTA_ENERGY_MAX_GAP_MS 2000
+#endif
+
+// Number of screens a ProjectaFleet can schedule
+#ifndef PROJECTA_MAX_FLEET
+#if defined(__AVR__)
+#define PROJECTA_MAX_FLEET 8
+#else
+#define PROJECTA_MAX_FLEET 64
+#endif
+#endif
+
+// Number of mirror screens a ProjectaGroup can drive
+#ifndef PROJECTA_MAX_GROUP
+#if defined(__AVR__)
+#define PROJECTA_MAX_GROUP 4
+#else
+#define PROJECTA_MAX_GROUP 16
+#endif
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+#include <ProjectaDecoder.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <ProjectaNoHeap.h>
+
+#define PROJ_DIGIT_INVALID 0x80
+
+/* Digit byte -> digit value in the low nibble, decimal point
+ * kept at PROJ_SEG_DP, PROJ_DIGIT_INVALID if not a digit
+ */
+static constexpr uint8_t digitEntry(uint8_t b){
+    return (projectaSegmentsDigit(b & (uint8_t)~PROJ_SEG_DP) == 0xFF ?
+        PROJ_DIGIT_INVALID : projectaSegmentsDigit(b & (uint8_t)~PROJ_SEG_DP)) | (b & PROJ_SEG_DP);
+}
+
+/* Byte 5 -> battery type, in the order setBatteryType() sets them */
+static constexpr uint8_t batteryEntry(uint8_t b){
+    return (b & 0x40) ? BATTERY_GEL : (b & 0x04) ? BATTERY_AGM :
+           (b & 0x80) ? BATTERY_WET : (b & 0x08) ? BATTERY_CALCIUM : BATTERY_NONE;
+}
+
+/* Byte 4 -> battery bar level (top nibble fills from bit 7) */
+static constexpr uint8_t barEntry(uint8_t b){
+    return (b & 0xF0) == 0xF0 ? 4 : (b & 0xE0) == 0xE0 ? 3 :
+           (b & 0xC0) == 0xC0 ? 2 : (b & 0x80) ? 1 : 0;
+}
+
+static const uint8_t _digitTable[256] PROGMEM = { PROJ_TABLE256(digitEntry) };
+static const uint8_t _unitTable[256] PROGMEM = { PROJ_TABLE256(projectaCodeUnit) };
+static const uint8_t _batteryTable[256] PROGMEM = { PROJ_TABLE256(batteryEntry) };
+static const uint8_t _barTable[256] PROGMEM = { PROJ_TABLE256(barEntry) };
+static const int16_t _decimalScale[3] = {1000, 100, 10};
+
+/* Function to decode a raw display frame
+ * @input -> 10 byte frame, telemetry struct to fill in
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHECKSUM_INVALID (fields are still decoded)
+ *      PROJ_CHARACTER_INVALID (digits show text, raw = -1)
+ */
+projecta_error projectaDecodeFrame(const uint8_t* frame, projecta_telemetry& out){
+    uint8_t sum = 0;
+    for(int i=0;i<9;i++){
+        sum += frame[i];
+    }
+    out.checksumValid = (sum == frame[9]);
+
+    out.unit = pgm_read_byte(&_unitTable[frame[0]]);
+    out.bar = (frame[6] & 0x10) ? pgm_read_byte(&_barTable[frame[4]]) : 0;
+    out.battery = (frame[6] & 0x08) ? (uint8_t)BATTERY_POWER_SUPPLY : pgm_read_byte(&_batteryTable[frame[5]]);
+    out.leds = frame[7] & 0x1F;
+    out.buzzer = frame[7] & 0x20;
+
+    uint8_t h = pgm_read_byte(&_digitTable[frame[3]]);
+    uint8_t t = pgm_read_byte(&_digitTable[frame[2]]);
+    uint8_t o = pgm_read_byte(&_digitTable[frame[1]]);
+    out.decimals = (h & PROJ_SEG_DP) ? 2 : (t & PROJ_SEG_DP) ? 1 : 0;
+    if((h | t | o) & PROJ_DIGIT_INVALID){
+        out.raw = -1;
+        out.milli = 0;
+        return PROJ_CHARACTER_INVALID;
+    }
+    out.raw = (h & 0x0F) * 100 + (t & 0x0F) * 10 + (o & 0x0F);
+    out.milli = (int32_t)out.raw * _decimalScale[out.decimals];
+    return out.checksumValid ? PROJ_OK : PROJ_CHECKSUM_INVALID;
+}
+
+/* Function to decode one frame into entry i of the columns
+ * @input -> frames, columns, index
+ * @returns -> true if the checksum matched
+ */
+static bool decodeColumn(const uint8_t* frames, const projecta_columns& out, size_t i){
+    projecta_telemetry tel;
+    projectaDecodeFrame(frames + i * 10, tel);
+    out.milli[i] = tel.milli;
+    out.raw[i] = tel.raw;
+    out.decimals[i] = tel.decimals;
+    out.unit[i] = tel.unit;
+    out.battery[i] = tel.battery;
+    out.bar[i] = tel.bar;
+    out.leds[i] = tel.leds;
+    out.buzzer[i] = tel.buzzer;
+    out.checksumValid[i] = tel.checksumValid;
+    return tel.checksumValid;
+}
+
+#if defined(__SSE2__)
+/* Lanes of a where mask is set, of b elsewhere */
+static inline __m128i selectBytes(__m128i mask, __m128i a, __m128i b){
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Bytes with all the bits of m set -> 0xFF */
+static inline __m128i allSet(__m128i v, uint8_t m){
+    __m128i mv = _mm_set1_epi8((char)m);
+    return _mm_cmpeq_epi8(_mm_and_si128(v, mv), mv);
+}
+
+/* Digit byte column -> digit values, found = 0xFF where the
+ * byte (decimal point masked off) is a digit
+ */
+static inline __m128i digitLanes(__m128i seg, __m128i& found){
+    seg = _mm_and_si128(seg, _mm_set1_epi8((char)(uint8_t)~PROJ_SEG_DP));
+    __m128i acc = _mm_setzero_si128();
+    found = _mm_setzero_si128();
+    for(uint8_t d=0;d<10;d++){
+        __m128i eq = _mm_cmpeq_epi8(seg, _mm_set1_epi8((char)projectaDigitSegments(d)));
+        acc = _mm_or_si128(acc, _mm_and_si128(eq, _mm_set1_epi8((char)d)));
+        found = _mm_or_si128(found, eq);
+    }
+    return acc;
+}
+
+/* Stores 8 16 bit raw values and their milli values
+ * @input -> raw (-1 where not a number), decimals widened
+ * to 16 bits, output pointers
+ */
+static inline void storeValues(__m128i raw, __m128i dec, int16_t* rawOut, int32_t* milliOut){
+    __m128i scale = selectBytes(_mm_cmpeq_epi16(dec, _mm_set1_epi16(2)), _mm_set1_epi16(10),
+                    selectBytes(_mm_cmpeq_epi16(dec, _mm_set1_epi16(1)), _mm_set1_epi16(100),
+                    _mm_set1_epi16(1000)));
+    __m128i val = _mm_andnot_si128(_mm_cmpeq_epi16(raw, _mm_set1_epi16(-1)), raw);
+    __m128i lo = _mm_mullo_epi16(val, scale);
+    __m128i hi = _mm_mulhi_epu16(val, scale);
+    _mm_storeu_si128((__m128i*)rawOut, raw);
+    _mm_storeu_si128((__m128i*)milliOut, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i*)(milliOut + 4), _mm_unpackhi_epi16(lo, hi));
+}
+
+/* Function to decode 16 frames at once. Each frame is loaded
+ * as 16 bytes (the frame and 6 bytes past it), the 16x16
+ * block is transposed so each vector holds one frame byte of
+ * all 16 frames, and every field is worked out with compares
+ * and masks instead of table lookups.
+ * @input -> frames, columns, index of the first frame (16
+ * bytes must be readable from frame i + 15)
+ * @returns -> frames with a bad checksum
+ */
+static uint8_t decodeGroup(const uint8_t* frames, const projecta_columns& out, size_t i){
+    __m128i c[16];
+    for(uint8_t k=0;k<16;k++){
+        c[k] = _mm_loadu_si128((const __m128i*)(frames + (i + k) * 10));
+    }
+    // Four rounds of interleaving the two halves transpose 16x16 bytes
+    for(uint8_t round=0;round<4;round++){
+        __m128i t[16];
+        for(uint8_t k=0;k<8;k++){
+            t[2 * k] = _mm_unpacklo_epi8(c[k], c[k + 8]);
+            t[2 * k + 1] = _mm_unpackhi_epi8(c[k], c[k + 8]);
+        }
+        for(uint8_t k=0;k<16;k++){
+            c[k] = t[k];
+        }
+    }
+    const __m128i one = _mm_set1_epi8(1);
+
+    __m128i sum = c[0];
+    for(uint8_t k=1;k<9;k++){
+        sum = _mm_add_epi8(sum, c[k]);
+    }
+    __m128i valid = _mm_cmpeq_epi8(sum, c[9]);
+    _mm_storeu_si128((__m128i*)(out.checksumValid + i), _mm_and_si128(valid, one));
+
+    __m128i unit = _mm_setzero_si128();
+    __m128i known = _mm_setzero_si128();
+    for(uint8_t u=UNIT_NONE;u<UNIT_UNKNOWN;u++){
+        __m128i eq = _mm_cmpeq_epi8(c[0], _mm_set1_epi8((char)projectaUnitCode(u)));
+        unit = _mm_or_si128(unit, _mm_and_si128(eq, _mm_set1_epi8((char)u)));
+        known = _mm_or_si128(known, eq);
+    }
+    _mm_storeu_si128((__m128i*)(out.unit + i), selectBytes(known, unit, _mm_set1_epi8(UNIT_UNKNOWN)));
+
+    // Bar fills from bit 7, so the level is the number of filled prefixes
+    __m128i bar = _mm_setzero_si128();
+    bar = _mm_sub_epi8(bar, allSet(c[4], 0x80));
+    bar = _mm_sub_epi8(bar, allSet(c[4], 0xC0));
+    bar = _mm_sub_epi8(bar, allSet(c[4], 0xE0));
+    bar = _mm_sub_epi8(bar, allSet(c[4], 0xF0));
+    _mm_storeu_si128((__m128i*)(out.bar + i), _mm_and_si128(allSet(c[6], 0x10), bar));
+
+    // Lowest priority first, as batteryEntry()
+    __m128i bat = _mm_setzero_si128();
+    bat = selectBytes(allSet(c[5], 0x08), _mm_set1_epi8(BATTERY_CALCIUM), bat);
+    bat = selectBytes(allSet(c[5], 0x80), _mm_set1_epi8(BATTERY_WET), bat);
+    bat = selectBytes(allSet(c[5], 0x04), _mm_set1_epi8(BATTERY_AGM), bat);
+    bat = selectBytes(allSet(c[5], 0x40), _mm_set1_epi8(BATTERY_GEL), bat);
+    bat = selectBytes(allSet(c[6], 0x08), _mm_set1_epi8(BATTERY_POWER_SUPPLY), bat);
+    _mm_storeu_si128((__m128i*)(out.battery + i), bat);
+
+    _mm_storeu_si128((__m128i*)(out.leds + i), _mm_and_si128(c[7], _mm_set1_epi8(0x1F)));
+    _mm_storeu_si128((__m128i*)(out.buzzer + i), _mm_and_si128(_mm_srli_epi16(c[7], 5), one));
+
+    __m128i hDp = allSet(c[3], PROJ_SEG_DP);
+    __m128i tDp = allSet(c[2], PROJ_SEG_DP);
+    __m128i dec = _mm_or_si128(_mm_and_si128(hDp, _mm_set1_epi8(2)), _mm_andnot_si128(hDp, _mm_and_si128(tDp, one)));
+    _mm_storeu_si128((__m128i*)(out.decimals + i), dec);
+
+    __m128i fh, ft, fo;
+    __m128i h = digitLanes(c[3], fh);
+    __m128i t = digitLanes(c[2], ft);
+    __m128i o = digitLanes(c[1], fo);
+    __m128i bad = _mm_andnot_si128(_mm_and_si128(fh, _mm_and_si128(ft, fo)), _mm_set1_epi8(-1));
+    const __m128i zero = _mm_setzero_si128();
+    for(uint8_t half=0;half<2;half++){
+        __m128i h16 = half ? _mm_unpackhi_epi8(h, zero) : _mm_unpacklo_epi8(h, zero);
+        __m128i t16 = half ? _mm_unpackhi_epi8(t, zero) : _mm_unpacklo_epi8(t, zero);
+        __m128i o16 = half ? _mm_unpackhi_epi8(o, zero) : _mm_unpacklo_epi8(o, zero);
+        __m128i bad16 = half ? _mm_unpackhi_epi8(bad, bad) : _mm_unpacklo_epi8(bad, bad);
+        __m128i dec16 = half ? _mm_unpackhi_epi8(dec, zero) : _mm_unpacklo_epi8(dec, zero);
+        __m128i raw = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(h16, _mm_set1_epi16(100)),
+                      _mm_mullo_epi16(t16, _mm_set1_epi16(10))), o16);
+        storeValues(_mm_or_si128(raw, bad16), dec16, out.raw + i + half * 8, out.milli + i + half * 8);
+    }
+    return (uint8_t)(16 - __builtin_popcount(_mm_movemask_epi8(valid)));
+}
+#endif
+
+/* Function to decode a packed array of frames into columns,
+ * e.g. a day of captures for offline analysis. Gives the
+ * same values as projectaDecodeFrame() for every frame.
+ * Frames are independent, so large arrays can be split
+ * across threads by calling this on disjoint ranges.
+ * @input -> count frames of 10 bytes back to back, columns
+ * with room for count entries each
+ * @returns -> number of frames with a bad checksum
+ */
+size_t projectaDecodeFrames(const uint8_t* frames, size_t count, const projecta_columns& out){
+    size_t bad = 0;
+    size_t i = 0;
+    #if defined(__SSE2__)
+    // The last frame of a group is read 16 bytes wide
+    for(; i + 16 < count; i += 16){
+        bad += decodeGroup(frames, out, i);
+    }
+    #endif
+    for(; i < count; i++){
+        bad += !decodeColumn(frames, out, i);
+    }
+    return bad;
+}
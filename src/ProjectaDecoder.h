@@ -0,0 +1,42 @@
+/* Projecta Library - Ben Soutter 2018
+ * Reverse of the frame encoder: turns a raw 10 byte display
+ * frame (e.g. one captured in slave mode) back into the
+ * values shown on the screen. projectaDecodeFrames() does
+ * the same for a packed array of frames into columns, 16
+ * frames at a time with SSE2 where the compiler targets it.
+ */
+#ifndef ProjectaDecoder_h
+#define ProjectaDecoder_h
+#include <Projecta.h>
+
+typedef struct{
+    int32_t milli;          // displayed value x1000 in the displayed unit
+    int16_t raw;            // displayed digits as an integer (0-999), -1 if not a number
+    uint8_t decimals;       // digits after the decimal point (0-2)
+    uint8_t unit;           // projecta_unit
+    uint8_t battery;        // projecta_battery_type
+    uint8_t bar;            // battery bar level 0-4
+    uint8_t leds;           // LED bits, bit n set = projecta_led (4 - n) on
+    bool buzzer;
+    bool checksumValid;
+}projecta_telemetry;
+
+/* Column arrays for projectaDecodeFrames(), one entry per
+ * frame, same fields as projecta_telemetry
+ */
+typedef struct{
+    int32_t* milli;
+    int16_t* raw;
+    uint8_t* decimals;
+    uint8_t* unit;
+    uint8_t* battery;
+    uint8_t* bar;
+    uint8_t* leds;
+    uint8_t* buzzer;        // 0 or 1
+    uint8_t* checksumValid; // 0 or 1
+}projecta_columns;
+
+projecta_error projectaDecodeFrame(const uint8_t* frame, projecta_telemetry& out);
+size_t projectaDecodeFrames(const uint8_t* frames, size_t count, const projecta_columns& out);
+
+#endif
@@ -0,0 +1,269 @@
+#include <ProjectaEnergy.h>
+#include <ProjectaNoHeap.h>
+
+#define PROJ_MS_PER_HOUR 3600000UL
+
+/* Function to add value x time to an integral, carrying
+ * whole hours out of the remainder. A step rarely adds an
+ * hour's worth, so the division is usually skipped.
+ * @input -> integral, value x1000 (< 1000000), time step ms
+ * (<= PROJECTA_ENERGY_MAX_GAP_MS)
+ * @returns -> NULL
+ */
+static void accumulate(projecta_integral& acc, uint32_t milli, uint32_t dt){
+    uint32_t inc = milli * dt;
+    if(inc >= PROJ_MS_PER_HOUR){
+        acc.hours += inc / PROJ_MS_PER_HOUR;
+        inc %= PROJ_MS_PER_HOUR;
+    }
+    acc.rem += inc;
+    if(acc.rem >= PROJ_MS_PER_HOUR){
+        acc.rem -= PROJ_MS_PER_HOUR;
+        acc.hours++;
+    }
+}
+
+ProjectaEnergy::ProjectaEnergy(){
+    reset();
+}
+
+/* Function to start a new session: clears the totals, the
+ * ranges and the held voltage and current
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaEnergy::reset(){
+    _volt = {0, 0};
+    _amp = {0, 0};
+    _watt = {0, 0};
+    for(uint8_t i=0;i<3;i++){
+        _min[i] = 0xFFFFFFFF;
+        _max[i] = 0;
+    }
+    _mV = _mA = _mW = 0;
+    _haveVolt = _haveAmp = false;
+    _started = false;
+    _usRem = 0;
+    _durationMs = _chargingMs = 0;
+    _gaps = 0;
+}
+
+/* Function to integrate the held values over a time step.
+ * Nothing is counted until both a voltage and a current have
+ * been seen; a step longer than PROJECTA_ENERGY_MAX_GAP_MS is
+ * a gap in the data, so it is skipped and the held values are
+ * dropped.
+ * @input -> time step ms
+ * @returns -> NULL
+ */
+void ProjectaEnergy::advance(uint32_t dt){
+    if(dt > PROJECTA_ENERGY_MAX_GAP_MS){
+        _gaps++;
+        _haveVolt = _haveAmp = false;
+        return;
+    }
+    if(!_haveVolt || !_haveAmp){
+        return;
+    }
+    accumulate(_volt, _mV, dt);
+    accumulate(_amp, _mA, dt);
+    // Power can exceed 1000000 mW: integrate whole watts
+    // (3600 W ms = 1 mWh) and the mW part separately
+    uint32_t wms = (_mW / 1000) * dt;
+    _watt.hours += wms / 3600;
+    accumulate(_watt, _mW % 1000, dt);
+    _watt.rem += (wms % 3600) * 1000;
+    if(_watt.rem >= PROJ_MS_PER_HOUR){
+        _watt.rem -= PROJ_MS_PER_HOUR;
+        _watt.hours++;
+    }
+    _durationMs += dt;
+    if(_mA){
+        _chargingMs += dt;
+    }
+}
+
+/* Function to hold a new voltage or current until the next
+ * sample and update the ranges
+ * @input -> projecta_unit, value x1000
+ * @returns -> NULL
+ */
+void ProjectaEnergy::hold(uint8_t unit, uint32_t milli){
+    uint8_t ch;
+    if(unit == UNIT_VOLT){
+        _mV = milli;
+        _haveVolt = true;
+        ch = 0;
+    }else if(unit == UNIT_AMP){
+        _mA = milli;
+        _haveAmp = true;
+        ch = 1;
+    }else{
+        return;
+    }
+    _min[ch] = milli < _min[ch] ? milli : _min[ch];
+    _max[ch] = milli > _max[ch] ? milli : _max[ch];
+    if(_haveVolt && _haveAmp){
+        // mV * mA / 1000 without a 64 bit product
+        _mW = (_mV / 1000) * _mA + (_mV % 1000) * _mA / 1000;
+        _min[2] = _mW < _min[2] ? _mW : _min[2];
+        _max[2] = _mW > _max[2] ? _mW : _max[2];
+    }
+}
+
+/* Function to add one displayed value. The time since the
+ * previous sample is integrated with the values held before
+ * this one, then a voltage or current is held; other units
+ * only mark the time.
+ * @input -> displayed unit, value x1000 (mV, mA), millis()
+ * of the sample
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_NUMBER_TOO_BIG (negative or 1000000 and over,
+ *      the sample is ignored)
+ */
+projecta_error ProjectaEnergy::addSample(projecta_unit unit, int32_t milli, uint32_t ms){
+    if(milli < 0 || milli >= 1000000){
+        return PROJ_NUMBER_TOO_BIG;
+    }
+    if(_started){
+        advance(ms - _last);
+    }
+    _started = true;
+    _last = ms;
+    hold(unit, milli);
+    return PROJ_OK;
+}
+
+/* Function to add a decoded frame, see addSample()
+ * @input -> telemetry from projectaDecodeFrame(), millis()
+ * of the frame
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHECKSUM_INVALID (the frame is ignored)
+ *      PROJ_CHARACTER_INVALID (text shown, only marks the time)
+ */
+projecta_error ProjectaEnergy::addTelemetry(const projecta_telemetry& tel, uint32_t ms){
+    if(!tel.checksumValid){
+        return PROJ_CHECKSUM_INVALID;
+    }
+    if(tel.raw < 0){
+        addSample(UNIT_NONE, 0, ms);
+        return PROJ_CHARACTER_INVALID;
+    }
+    return addSample((projecta_unit)tel.unit, tel.milli, ms);
+}
+
+/* Function to add a slave mode capture, timed by its micros()
+ * stamp so batches drained late still integrate correctly.
+ * Button replies are skipped. Do not mix with addSample() in
+ * one session, the time bases differ.
+ * @input -> capture from getCaptures()
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHECKSUM_INVALID (also for short frames, ignored)
+ *      PROJ_CHARACTER_INVALID (text shown, only marks the time)
+ */
+projecta_error ProjectaEnergy::addCapture(const projecta_capture& cap){
+    if(cap.type != CAPTURE_FRAME){
+        return PROJ_OK;
+    }
+    projecta_telemetry tel;
+    if(cap.length != 10 || projectaDecodeFrame(cap.data, tel) == PROJ_CHECKSUM_INVALID){
+        return PROJ_CHECKSUM_INVALID;
+    }
+    if(_started){
+        uint32_t us = cap.micros - _last;
+        if(us > PROJECTA_ENERGY_MAX_GAP_MS * 1000UL){
+            advance(us / 1000);
+            _usRem = 0;
+        }else{
+            us += _usRem;
+            advance(us / 1000);
+            _usRem = us % 1000;
+        }
+    }
+    _started = true;
+    _last = cap.micros;
+    if(tel.raw < 0){
+        return PROJ_CHARACTER_INVALID;
+    }
+    hold(tel.unit, tel.milli);
+    return PROJ_OK;
+}
+
+/* Function to get the charge delivered this session, e.g.
+ * for setAh_mAh()
+ * @input -> NULL
+ * @returns -> mAh
+ */
+uint32_t ProjectaEnergy::getCharge_mAh(){
+    return _amp.hours;
+}
+
+/* Function to get the energy delivered this session, e.g.
+ * for setWh_mWh()
+ * @input -> NULL
+ * @returns -> mWh
+ */
+uint32_t ProjectaEnergy::getEnergy_mWh(){
+    return _watt.hours;
+}
+
+/* Function to get the time integrated so far
+ * @input -> NULL
+ * @returns -> ms with both voltage and current known
+ */
+uint32_t ProjectaEnergy::getDuration(){
+    return _durationMs;
+}
+
+/* Function to get the time current was flowing
+ * @input -> NULL
+ * @returns -> ms with a non-zero current
+ */
+uint32_t ProjectaEnergy::getChargeTime(){
+    return _chargingMs;
+}
+
+/* Function to get the number of gaps in the data, see
+ * PROJECTA_ENERGY_MAX_GAP_MS
+ * @input -> NULL
+ * @returns -> gaps skipped
+ */
+uint32_t ProjectaEnergy::getGaps(){
+    return _gaps;
+}
+
+/* Function to get the minimum, maximum and time weighted
+ * average of a quantity this session
+ * @input -> UNIT_VOLT, UNIT_AMP or UNIT_WATT
+ * @returns -> range x1000 (mV, mA, mW), all 0 for other units
+ * or before any sample
+ */
+projecta_range ProjectaEnergy::getRange(projecta_unit unit){
+    projecta_range r = {0, 0, 0};
+    const projecta_integral* acc;
+    uint8_t ch;
+    if(unit == UNIT_VOLT){
+        acc = &_volt;
+        ch = 0;
+    }else if(unit == UNIT_AMP){
+        acc = &_amp;
+        ch = 1;
+    }else if(unit == UNIT_WATT){
+        acc = &_watt;
+        ch = 2;
+    }else{
+        return r;
+    }
+    if(_max[ch] < _min[ch]){
+        return r;
+    }
+    r.min = _min[ch];
+    r.max = _max[ch];
+    if(_durationMs){
+        r.average = ((uint64_t)acc->hours * PROJ_MS_PER_HOUR + acc->rem) / _durationMs;
+    }
+    return r;
+}
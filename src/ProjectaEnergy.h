@@ -0,0 +1,62 @@
+/* Projecta Library - Ben Soutter 2018
+ * Running charge and energy totals from sniffed telemetry.
+ * Every sample integrates the time since the previous one
+ * with the last voltage and current seen (the charger shows
+ * them on alternate frames), using 32 bit fixed point
+ * accumulators that carry whole mAh/mWh as they fill up.
+ * Totals, ranges and averages are read in constant time.
+ */
+#ifndef ProjectaEnergy_h
+#define ProjectaEnergy_h
+#include <ProjectaDecoder.h>
+
+static_assert(PROJECTA_ENERGY_MAX_GAP_MS <= 2000, "value x gap must fit in 32 bits");
+
+// Time integral of a value x1000: whole milli-unit hours plus
+// the remainder in milli-unit milliseconds
+typedef struct{
+    uint32_t hours;
+    uint32_t rem;       // < 3600000
+}projecta_integral;
+
+typedef struct{
+    uint32_t min;       // x1000 (mV, mA, mW), 0 before any sample
+    uint32_t max;
+    uint32_t average;   // time weighted over getDuration()
+}projecta_range;
+
+class ProjectaEnergy{
+    private:
+        projecta_integral _volt;
+        projecta_integral _amp;
+        projecta_integral _watt;
+        uint32_t _min[3];
+        uint32_t _max[3];
+        uint32_t _mV = 0;
+        uint32_t _mA = 0;
+        uint32_t _mW = 0;           // _mV * _mA / 1000, kept up to date
+        bool _haveVolt = false;
+        bool _haveAmp = false;
+        bool _started = false;
+        uint32_t _last = 0;         // time of the previous sample
+        uint16_t _usRem = 0;        // sub-ms part of capture time steps
+        uint32_t _durationMs = 0;
+        uint32_t _chargingMs = 0;
+        uint32_t _gaps = 0;
+        void advance(uint32_t dt);
+        void hold(uint8_t unit, uint32_t milli);
+    public:
+        ProjectaEnergy();
+        void reset();
+        projecta_error addSample(projecta_unit unit, int32_t milli, uint32_t ms);
+        projecta_error addTelemetry(const projecta_telemetry& tel, uint32_t ms);
+        projecta_error addCapture(const projecta_capture& cap);
+        uint32_t getCharge_mAh();
+        uint32_t getEnergy_mWh();
+        uint32_t getDuration();
+        uint32_t getChargeTime();
+        uint32_t getGaps();
+        projecta_range getRange(projecta_unit unit);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <ProjectaFleet.h>
+#include <ProjectaNoHeap.h>
+
+/* Member order: screens directly on a bus first, then by
+ * bus, mux address and channel
+ * @input -> two members
+ * @returns -> true if a is served before b
+ */
+bool ProjectaFleet::before(Projecta* a, Projecta* b){
+    ProjectaMux* ma = a->getMux();
+    ProjectaMux* mb = b->getMux();
+    if(!ma || !mb){
+        return !ma && mb;
+    }
+    if(&ma->getWire() != &mb->getWire()){
+        return (uintptr_t)&ma->getWire() < (uintptr_t)&mb->getWire();
+    }
+    if(ma->getAddress() != mb->getAddress()){
+        return ma->getAddress() < mb->getAddress();
+    }
+    return a->getMuxChannel() < b->getMuxChannel();
+}
+
+/* Function to add a screen to the fleet, in channel order
+ * @input -> screen, usually built with Projecta(mux, channel)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED (PROJECTA_MAX_FLEET reached)
+ */
+projecta_error ProjectaFleet::add(Projecta& screen){
+    if(_count >= PROJECTA_MAX_FLEET){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    uint8_t i = _count++;
+    while(i > 0 && before(&screen, _members[i - 1])){
+        _members[i] = _members[i - 1];
+        i--;
+    }
+    _members[i] = &screen;
+    _cursor = 0;
+    return PROJ_OK;
+}
+
+/* Begin Function to start every member. All members are
+ * started even if some of them fail; those come up through
+ * the link probe once their screen answers.
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      the first error of any member
+ */
+projecta_error ProjectaFleet::begin(){
+    projecta_error result = PROJ_OK;
+    for(uint8_t i=0;i<_count;i++){
+        projecta_error err = _members[i]->begin();
+        if(result == PROJ_OK){
+            result = err;
+        }
+    }
+    return result;
+}
+
+/* Loop function which user must call as often as possible.
+ * Runs one round: every member's loop() in channel order,
+ * starting at the member served last so its channel, still
+ * open, is used first.
+ * @input -> NULL
+ * @returns -> earliest millis() deadline of any member
+ */
+uint32_t ProjectaFleet::loop(){
+    uint32_t deadline = millis() + 1000;
+    uint8_t i = _cursor;
+    for(uint8_t n=0;n<_count;n++){
+        Projecta* p = _members[i];
+        if((int32_t)(p->getNextDeadline() - millis()) <= 0){
+            _cursor = i;
+        }
+        p->loop();
+        uint32_t next = p->getNextDeadline();
+        if((int32_t)(next - deadline) < 0){
+            deadline = next;
+        }
+        if(++i == _count){
+            i = 0;
+        }
+    }
+    return deadline;
+}
+
+/* Function to get the number of members
+ * @input -> NULL
+ * @returns -> members added
+ */
+uint8_t ProjectaFleet::size(){
+    return _count;
+}
+
+/* Function to get a member in service order
+ * @input -> index 0 to size() - 1
+ * @returns -> member, NULL if the index is out of range
+ */
+Projecta* ProjectaFleet::getMember(uint8_t index){
+    return index < _count ? _members[index] : NULL;
+}
@@ -0,0 +1,29 @@
+/* Projecta Library - Ben Soutter 2018
+ * Round robin scheduler for many screens behind I2C muxes.
+ * Members are kept ordered by bus, mux and channel, so one
+ * round opens each mux once and walks its channels in
+ * order, and all due work of a screen (link probe, button
+ * read, frame write) is done while its channel is open.
+ * Screens with nothing due cost no channel switch at all,
+ * and a mux is only closed when the round moves on to the
+ * next one.
+ */
+#ifndef ProjectaFleet_h
+#define ProjectaFleet_h
+#include <ProjectaMux.h>
+
+class ProjectaFleet{
+    private:
+        Projecta* _members[PROJECTA_MAX_FLEET];
+        uint8_t _count = 0;
+        uint8_t _cursor = 0;    // member served last, the next round starts there
+        static bool before(Projecta* a, Projecta* b);
+    public:
+        projecta_error add(Projecta& screen);
+        projecta_error begin();
+        uint32_t loop();
+        uint8_t size();
+        Projecta* getMember(uint8_t index);
+};
+
+#endif
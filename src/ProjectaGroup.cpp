@@ -0,0 +1,277 @@
+#include <ProjectaGroup.h>
+#include <Wire.h>
+#include <ProjectaNoHeap.h>
+
+/* Constructor taking the screen whose frame is mirrored
+ */
+ProjectaGroup::ProjectaGroup(Projecta& leader) : _leader(&leader){
+    memset(_frame, 0, sizeof(_frame));
+}
+
+projecta_error ProjectaGroup::addMirror(TwoWire* wire, ProjectaMux* mux, uint8_t channel){
+    if(_count >= PROJECTA_MAX_GROUP){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    projecta_mirror& m = _mirrors[_count++];
+    m.wire = wire;
+    m.mux = mux;
+    m.channel = channel;
+    m.buttons = 0;
+    m.rawButtons = 0;
+    m.rawSince = 0;
+    m.failures = 0;
+    m.linkUp = true;
+    m.sentGeneration = _generation - 1;
+    m.backoffMs = 0;
+    m.nextProbeMs = 0;
+    m.errors = 0;
+    return PROJ_OK;
+}
+
+/* Function to add a mirror directly on a bus (at 0x65, so
+ * one per bus)
+ * @input -> bus, already started
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED (PROJECTA_MAX_GROUP reached)
+ */
+projecta_error ProjectaGroup::add(TwoWire& wire){
+    return addMirror(&wire, NULL, 0);
+}
+
+/* Function to add a mirror behind a mux channel. Adding
+ * mirrors in channel order keeps mux switches down.
+ * @input -> mux, channel 0-7
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_FIELD_INVALID (channel is not 0-7)
+ *      PROJ_LIMIT_2_EXCEEDED (PROJECTA_MAX_GROUP reached)
+ */
+projecta_error ProjectaGroup::add(ProjectaMux& mux, uint8_t channel){
+    if(channel > 7){
+        return PROJ_FIELD_INVALID;
+    }
+    return addMirror(&mux.getWire(), &mux, channel);
+}
+
+/* Begin Function to start the leader and check every mirror
+ * answers. Mirrors that do not are retried by loop() with
+ * the link backoff. Buses other than the leader's must be
+ * started by the application first.
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      the leader's begin() error
+ *      PROJ_I2C_ERROR (a mirror did not answer)
+ */
+projecta_error ProjectaGroup::begin(){
+    projecta_error result = _leader->begin();
+    for(uint8_t i=0;i<_count;i++){
+        _mirrors[i].linkUp = false;
+        probe(_mirrors[i]);
+        if(!_mirrors[i].linkUp && result == PROJ_OK){
+            result = PROJ_I2C_ERROR;
+        }
+    }
+    return result;
+}
+
+bool ProjectaGroup::select(projecta_mirror& m){
+    return !m.mux || m.mux->select(m.channel) == PROJ_OK;
+}
+
+/* Function to feed a transaction result into a mirror's link
+ * state, as Projecta::linkResult()
+ * @input -> mirror, true if the transaction succeeded
+ * @returns -> NULL
+ */
+void ProjectaGroup::result(projecta_mirror& m, bool ok){
+    if(ok){
+        m.failures = 0;
+        return;
+    }
+    m.errors++;
+    if(m.mux){
+        m.mux->invalidate();
+    }
+    if(++m.failures >= PROJECTA_LINK_FAILURES){
+        m.linkUp = false;
+        m.failures = 0;
+        m.backoffMs = PROJECTA_BACKOFF_MIN_MS;
+        m.nextProbeMs = millis() + m.backoffMs;
+    }
+}
+
+/* Function to send an address-only probe to a mirror whose
+ * link is down. On success the current frame is resent.
+ * @input -> mirror
+ * @returns -> NULL
+ */
+void ProjectaGroup::probe(projecta_mirror& m){
+    bool ok = select(m);
+    if(ok){
+        m.wire->beginTransmission(0x65);
+        ok = m.wire->endTransmission() == 0;
+    }
+    if(ok){
+        m.linkUp = true;
+        m.failures = 0;
+        m.sentGeneration = _generation - 1;
+        return;
+    }
+    m.errors++;
+    if(m.mux){
+        m.mux->invalidate();
+    }
+    m.backoffMs = m.backoffMs >= PROJECTA_BACKOFF_MAX_MS / 2 ? PROJECTA_BACKOFF_MAX_MS :
+                  m.backoffMs ? m.backoffMs * 2 : PROJECTA_BACKOFF_MIN_MS;
+    m.nextProbeMs = millis() + m.backoffMs;
+}
+
+/* Function to read a mirror's buttons and report a change.
+ * A new level is only taken once it has been read unchanged
+ * for the debounce time, so with the default timings it must
+ * be seen on two polls in a row.
+ * @input -> mirror index
+ * @returns -> NULL
+ */
+void ProjectaGroup::readButtons(uint8_t member){
+    projecta_mirror& m = _mirrors[member];
+    uint32_t now = millis();
+    uint8_t n = select(m) ? m.wire->requestFrom(0x65, 3) : 0;
+    if(n == 3){
+        uint8_t raw = m.wire->TwoWire::read() & 0x0F;
+        m.wire->TwoWire::read();
+        m.wire->TwoWire::read();
+        if(raw != m.rawButtons){
+            m.rawButtons = raw;
+            m.rawSince = now;
+        }
+    }
+    result(m, n == 3);
+    if(m.rawButtons != m.buttons && (uint32_t)(now - m.rawSince) >= _debounceMs){
+        m.buttons = m.rawButtons;
+        if(buttonCallback){
+            buttonCallback(member, m.buttons);
+        }
+    }
+}
+
+/* Function to set how often the mirrors' buttons are read
+ * @input -> interval in milliseconds (default 50)
+ * @returns -> ProjectaGroup reference for chaining
+ */
+ProjectaGroup& ProjectaGroup::setPollInterval(uint32_t ms){
+    _pollMs = ms;
+    return *this;
+}
+
+/* Function to set how long a mirror's buttons must read the
+ * same before a change is reported
+ * @input -> debounce time in milliseconds (default 20, 0 =
+ *           report every read as it comes)
+ * @returns -> ProjectaGroup reference for chaining
+ */
+ProjectaGroup& ProjectaGroup::setDebounce(uint16_t ms){
+    _debounceMs = ms;
+    return *this;
+}
+
+/* Function to set the callback for mirror buttons, called
+ * with the mirror index and its button bits whenever they
+ * change. The leader's buttons use the Projecta callbacks.
+ * @input -> callback or NULL
+ * @returns -> ProjectaGroup reference for chaining
+ */
+ProjectaGroup& ProjectaGroup::setButtonCallback(GROUP_BUTTON_CALLBACK_SIGNATURE){
+    this->buttonCallback = buttonCallback;
+    return *this;
+}
+
+/* Loop function which user must call as often as possible
+ * instead of the leader's loop(). Runs the leader, then in
+ * one pass over the mirrors sends the leader's frame to
+ * those that have not had it yet, reads their buttons when
+ * the poll is due and probes any that are down.
+ * @input -> NULL
+ * @returns -> earliest millis() deadline of any work
+ */
+uint32_t ProjectaGroup::loop(){
+    _leader->loop();
+    uint8_t frame[10];
+    _leader->getFrame(frame);
+    if(memcmp(frame, _frame, 10) != 0){
+        memcpy(_frame, frame, 10);
+        _generation++;
+    }
+    uint32_t now = millis();
+    bool poll = (int32_t)(now - _nextPollMs) >= 0;
+    if(poll){
+        _nextPollMs = now + _pollMs;
+    }
+    uint32_t deadline = _leader->getNextDeadline();
+    if((int32_t)(_nextPollMs - deadline) < 0){
+        deadline = _nextPollMs;
+    }
+    for(uint8_t i=0;i<_count;i++){
+        projecta_mirror& m = _mirrors[i];
+        if(!m.linkUp){
+            if((int32_t)(now - m.nextProbeMs) >= 0){
+                probe(m);
+            }
+        }
+        if(m.linkUp && m.sentGeneration != _generation){
+            bool ok = select(m);
+            if(ok){
+                m.wire->beginTransmission(0x65);
+                m.wire->TwoWire::write(_frame, 10);
+                ok = m.wire->endTransmission() == 0;
+            }
+            result(m, ok);
+            if(ok){
+                m.sentGeneration = _generation;
+            }
+        }
+        if(m.linkUp && poll){
+            readButtons(i);
+        }
+        if(!m.linkUp && (int32_t)(m.nextProbeMs - deadline) < 0){
+            deadline = m.nextProbeMs;
+        }else if(m.linkUp && m.sentGeneration != _generation){
+            deadline = now;
+        }
+    }
+    return deadline;
+}
+
+/* Function to get the number of mirrors
+ * @input -> NULL
+ * @returns -> mirrors added
+ */
+uint8_t ProjectaGroup::size(){
+    return _count;
+}
+
+/* Function to get a mirror's buttons
+ * @input -> mirror index, in the order added
+ * @returns -> projecta_button_id bits, 0 if out of range
+ */
+uint8_t ProjectaGroup::getButtons(uint8_t member){
+    return member < _count ? _mirrors[member].buttons : 0;
+}
+
+/* Function to get the state of a mirror's link
+ * @input -> mirror index
+ * @returns -> true if the mirror answered lately
+ */
+bool ProjectaGroup::isConnected(uint8_t member){
+    return member < _count && _mirrors[member].linkUp;
+}
+
+/* Function to get the failed transactions of a mirror
+ * @input -> mirror index
+ * @returns -> failed writes, reads and probes so far
+ */
+uint32_t ProjectaGroup::getErrors(uint8_t member){
+    return member < _count ? _mirrors[member].errors : 0;
+}
@@ -0,0 +1,62 @@
+/* Projecta Library - Ben Soutter 2018
+ * Broadcast group: several screens showing the same reading.
+ * The leader is a normal Projecta that owns the frame (all
+ * setters, pages and its own buttons); every other screen is
+ * a mirror of a few bytes that is sent the leader's frame
+ * when it changes. The frame is encoded once however many
+ * screens show it, and each mirror keeps its own link state,
+ * error count and buttons.
+ */
+#ifndef ProjectaGroup_h
+#define ProjectaGroup_h
+#include <ProjectaMux.h>
+
+#define GROUP_BUTTON_CALLBACK_SIGNATURE void (*buttonCallback)(uint8_t member, uint8_t buttons)   // Function Callback Definition
+
+typedef struct{
+    TwoWire* wire;
+    ProjectaMux* mux;           // NULL = screen directly on the bus
+    uint8_t channel;
+    uint8_t buttons;            // projecta_button_id bits, debounced
+    uint8_t rawButtons;         // bits from the last read
+    uint32_t rawSince;          // millis() when rawButtons last changed
+    uint8_t failures;           // failed transactions in a row
+    bool linkUp;
+    uint16_t sentGeneration;    // group frame last written
+    uint16_t backoffMs;
+    uint32_t nextProbeMs;
+    uint32_t errors;            // failed transactions in total
+}projecta_mirror;
+
+class ProjectaGroup{
+    private:
+        Projecta* _leader;
+        projecta_mirror _mirrors[PROJECTA_MAX_GROUP];
+        uint8_t _count = 0;
+        uint8_t _frame[10];         // leader frame the mirrors are sent
+        uint16_t _generation = 0;   // bumped when _frame changes
+        uint32_t _pollMs = 50;
+        uint32_t _nextPollMs = 0;
+        uint16_t _debounceMs = 20;
+        GROUP_BUTTON_CALLBACK_SIGNATURE = NULL;
+        projecta_error addMirror(TwoWire* wire, ProjectaMux* mux, uint8_t channel);
+        bool select(projecta_mirror& m);
+        void result(projecta_mirror& m, bool ok);
+        void probe(projecta_mirror& m);
+        void readButtons(uint8_t member);
+    public:
+        ProjectaGroup(Projecta& leader);
+        projecta_error add(TwoWire& wire);
+        projecta_error add(ProjectaMux& mux, uint8_t channel);
+        projecta_error begin();
+        ProjectaGroup& setPollInterval(uint32_t ms);
+        ProjectaGroup& setDebounce(uint16_t ms);
+        ProjectaGroup& setButtonCallback(GROUP_BUTTON_CALLBACK_SIGNATURE);
+        uint32_t loop();
+        uint8_t size();
+        uint8_t getButtons(uint8_t member);
+        bool isConnected(uint8_t member);
+        uint32_t getErrors(uint8_t member);
+};
+
+#endif
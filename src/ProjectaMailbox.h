@@ -0,0 +1,49 @@
+/* Projecta Library - Ben Soutter 2018
+ * Lock free single writer / single reader triple buffer.
+ * The writer always has a private slot to fill and publishes
+ * it with one atomic exchange; the reader picks up the
+ * newest published slot with another. Neither side ever
+ * waits, and intermediate values the reader did not get to
+ * are simply overwritten.
+ */
+#ifndef ProjectaMailbox_h
+#define ProjectaMailbox_h
+#include <Arduino.h>
+
+template<typename T>
+class ProjectaMailbox{
+    private:
+        static const uint8_t FRESH = 0x80;
+        T _slots[3];
+        uint8_t _back = 0;      // Only used by the writer
+        uint8_t _middle = 1;    // Exchanged by both, FRESH when unread
+        uint8_t _front = 2;     // Only used by the reader
+    public:
+        /* Writer: slot to fill in before publish() */
+        T& write(){
+            return _slots[_back];
+        }
+
+        /* Writer: hand the filled slot over to the reader */
+        void publish(){
+            _back = __atomic_exchange_n(&_middle, (uint8_t)(_back | FRESH), __ATOMIC_ACQ_REL) & 3;
+        }
+
+        /* Reader: take the newest published slot, if any
+         * @returns -> true if read() changed
+         */
+        bool update(){
+            if(!(__atomic_load_n(&_middle, __ATOMIC_ACQUIRE) & FRESH)){
+                return false;
+            }
+            _front = __atomic_exchange_n(&_middle, _front, __ATOMIC_ACQ_REL) & 3;
+            return true;
+        }
+
+        /* Reader: the slot taken by the last update() */
+        const T& read(){
+            return _slots[_front];
+        }
+};
+
+#endif
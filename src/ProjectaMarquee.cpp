@@ -0,0 +1,223 @@
+#include <ProjectaMarquee.h>
+#include <ProjectaNoHeap.h>
+
+ProjectaMarquee::ProjectaMarquee(Projecta& proj) : _proj(proj){
+    memset(_stream, 0, sizeof(_stream));
+}
+
+/* Function to encode a message into the segment stream. The
+ * text is checked completely before the stream is touched,
+ * so a rejected message leaves the current one running.
+ * @input -> text in RAM or in flash
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHARACTER_INVALID
+ *      PROJ_TEXT_TOO_LONG (longer than PROJECTA_MARQUEE_LEN)
+ */
+projecta_error ProjectaMarquee::encode(const char* text, bool flash){
+    uint16_t places = 0;
+    uint8_t prev = PROJ_SEG_DP;
+    for(uint16_t i=0;;i++){
+        char c = flash ? (char)pgm_read_byte(text + i) : text[i];
+        if(!c){
+            break;
+        }
+        uint8_t glyph = projectaGlyph(c);
+        if(glyph == PROJ_GLYPH_INVALID){
+            return PROJ_CHARACTER_INVALID;
+        }
+        if(glyph == PROJ_SEG_DP && !(prev & PROJ_SEG_DP)){
+            prev |= PROJ_SEG_DP;
+        }else{
+            prev = glyph;
+            places++;
+        }
+    }
+    if(places > PROJECTA_MARQUEE_LEN){
+        return PROJ_TEXT_TOO_LONG;
+    }
+
+    // Short messages stand still, longer ones scroll in from
+    // the right and out to the left
+    uint8_t* out = _stream;
+    if(places > 3){
+        *out++ = 0x00;
+        *out++ = 0x00;
+    }
+    uint8_t* first = out;
+    for(uint16_t i=0;;i++){
+        char c = flash ? (char)pgm_read_byte(text + i) : text[i];
+        if(!c){
+            break;
+        }
+        uint8_t glyph = projectaGlyph(c);
+        if(glyph == PROJ_SEG_DP && out > first && !(out[-1] & PROJ_SEG_DP)){
+            out[-1] |= PROJ_SEG_DP;
+        }else{
+            *out++ = glyph;
+        }
+    }
+    memset(out, 0, _stream + sizeof(_stream) - out);
+    _frames = NULL;
+    _positions = places > 3 ? places + 3 : 1;
+    restart();
+    return PROJ_OK;
+}
+
+/* Function to set the message and start showing it from the
+ * beginning. Up to three places are shown still; longer
+ * messages scroll one place per step. '.' lights the decimal
+ * point of the place before it.
+ * @input -> null terminated text, see projectaGlyph() for the
+ * characters that can be shown
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_CHARACTER_INVALID
+ *      PROJ_TEXT_TOO_LONG (longer than PROJECTA_MARQUEE_LEN)
+ */
+projecta_error ProjectaMarquee::setText(const char* text){
+    return encode(text, false);
+}
+
+/* Function to set the message from a flash string, e.g.
+ * F("CHARGING"), see setText(const char*)
+ * @input -> flash string
+ * @returns -> projecta_error, see setText(const char*)
+ */
+projecta_error ProjectaMarquee::setText(const __FlashStringHelper* text){
+    return encode(reinterpret_cast<const char*>(text), true);
+}
+
+/* Function to play an animation instead of text. Each frame
+ * is three raw segment patterns, left to right (see
+ * PROJ_SEG_A...PROJ_SEG_G); the table is read in place and
+ * must stay valid while it plays.
+ * @input -> PROGMEM table of count * 3 bytes, frame count
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_FIELD_INVALID (no frames)
+ */
+projecta_error ProjectaMarquee::setAnimation(const uint8_t* frames, uint8_t count){
+    if(!frames || !count){
+        return PROJ_FIELD_INVALID;
+    }
+    _frames = frames;
+    _positions = count;
+    restart();
+    return PROJ_OK;
+}
+
+/* Function to set the time each step stays on screen
+ * @input -> ms per step (default 300)
+ * @returns -> ProjectaMarquee reference for chaining
+ */
+ProjectaMarquee& ProjectaMarquee::setStepInterval(uint16_t ms){
+    _stepMs = ms;
+    return *this;
+}
+
+/* Function to set how many times the message or animation
+ * runs through before stopping. A scrolled message ends on a
+ * blank display.
+ * @input -> passes, 0 to repeat forever (default)
+ * @returns -> ProjectaMarquee reference for chaining
+ */
+ProjectaMarquee& ProjectaMarquee::setRepeat(uint8_t passes){
+    _repeat = passes;
+    return *this;
+}
+
+/* Function to rewind and show the first step on the next
+ * loop()
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMarquee::restart(){
+    _pos = 0;
+    _passes = 0;
+    _running = _positions != 0;
+    _nextStep = millis();
+}
+
+/* Function to run the current message or animation again
+ * from the beginning
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMarquee::start(){
+    restart();
+}
+
+/* Function to stop stepping. The display keeps the step
+ * shown last.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMarquee::stop(){
+    _running = false;
+}
+
+/* Function to check whether steps are still to come
+ * @input -> NULL
+ * @returns -> false once stopped, after the last pass, or
+ * once a still message has been shown
+ */
+bool ProjectaMarquee::isRunning(){
+    return _running;
+}
+
+/* Function to copy the current window into the frame and
+ * move on by one step
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMarquee::show(){
+    if(_frames){
+        const uint8_t* f = _frames + _pos * 3;
+        _proj.setSegments(pgm_read_byte(f), pgm_read_byte(f + 1), pgm_read_byte(f + 2));
+    }else{
+        const uint8_t* w = _stream + _pos;
+        _proj.setSegments(w[0], w[1], w[2]);
+    }
+    if(++_pos == _positions){
+        _pos = 0;
+        if(_positions == 1 && !_frames){
+            _running = false;   // still text, nothing more to do
+        }else if(_repeat && ++_passes >= _repeat){
+            _running = false;
+        }
+    }
+}
+
+/* Loop function which user must call as often as possible,
+ * before the Projecta object's loop() so a step is sent
+ * without delay. Takes at most one step per call; after a
+ * long stall it carries on from the current step rather than
+ * catching up.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMarquee::loop(){
+    if(!_running){
+        return;
+    }
+    uint32_t now = millis();
+    if((int32_t)(now - _nextStep) < 0){
+        return;
+    }
+    _nextStep += _stepMs;
+    if((int32_t)(now - _nextStep) >= 0){
+        _nextStep = now + _stepMs;
+    }
+    show();
+}
+
+/* Function to get when loop() next has work to do, to sleep
+ * until then
+ * @input -> NULL
+ * @returns -> millis() value of the next step, or now + 1000
+ * when nothing is running
+ */
+uint32_t ProjectaMarquee::getNextDeadline(){
+    return _running ? _nextStep : millis() + 1000;
+}
@@ -0,0 +1,45 @@
+/* Projecta Library - Ben Soutter 2018
+ * Scrolling text and simple animations on the three digit
+ * places. A message is encoded to segment patterns once,
+ * when it is set; each step afterwards only copies three
+ * bytes of that stream into the frame, so a long status
+ * message costs next to nothing while it scrolls.
+ */
+#ifndef ProjectaMarquee_h
+#define ProjectaMarquee_h
+#include <Projecta.h>
+
+static_assert(PROJECTA_MARQUEE_LEN <= 250, "marquee positions are counted in a uint8_t");
+
+class ProjectaMarquee{
+    private:
+        Projecta& _proj;
+        // Encoded message with two blanks before and three after
+        // so every three byte window lies inside the buffer
+        uint8_t _stream[PROJECTA_MARQUEE_LEN + 5];
+        const uint8_t* _frames = NULL;  // PROGMEM animation, 3 bytes per frame
+        uint8_t _positions = 0;         // steps in one pass
+        uint8_t _pos = 0;
+        uint8_t _repeat = 0;            // passes to run, 0 = forever
+        uint8_t _passes = 0;
+        bool _running = false;
+        uint16_t _stepMs = 300;
+        uint32_t _nextStep = 0;
+        projecta_error encode(const char* text, bool flash);
+        void restart();
+        void show();
+    public:
+        ProjectaMarquee(Projecta& proj);
+        projecta_error setText(const char* text);
+        projecta_error setText(const __FlashStringHelper* text);
+        projecta_error setAnimation(const uint8_t* frames, uint8_t count);
+        ProjectaMarquee& setStepInterval(uint16_t ms);
+        ProjectaMarquee& setRepeat(uint8_t passes);
+        void start();
+        void stop();
+        bool isRunning();
+        void loop();
+        uint32_t getNextDeadline();
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <ProjectaMux.h>
+#include <Wire.h>
+#include <ProjectaNoHeap.h>
+
+ProjectaMux* ProjectaMux::_muxes = NULL;
+
+/* Constructor binding the mux to its bus and address
+ * (0x70-0x77 on the TCA9548A)
+ */
+ProjectaMux::ProjectaMux(TwoWire& wire, uint8_t address) : _wire(&wire), _address(address){
+    _nextMux = _muxes;
+    _muxes = this;
+}
+
+ProjectaMux::~ProjectaMux(){
+    for(ProjectaMux** m = &_muxes; *m; m = &(*m)->_nextMux){
+        if(*m == this){
+            *m = _nextMux;
+            break;
+        }
+    }
+}
+
+/* Function to write the channel mask (one byte transaction)
+ * @input -> bit n set = channel n connected
+ * @returns -> true if the mux acknowledged
+ */
+bool ProjectaMux::writeMask(uint8_t mask){
+    _wire->beginTransmission(_address);
+    _wire->TwoWire::write(mask);
+    if(_wire->endTransmission() != 0){
+        _selected = PROJ_MUX_UNKNOWN;
+        return false;
+    }
+    _selected = mask;
+    _switches++;
+    return true;
+}
+
+/* Function to connect one channel to the bus. Nothing is
+ * written if it is already the only one connected. Any other
+ * mux on the same bus with a channel open is closed first.
+ * @input -> channel 0-7
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_FIELD_INVALID (channel is not 0-7)
+ *      PROJ_I2C_ERROR (a mux did not answer)
+ */
+projecta_error ProjectaMux::select(uint8_t channel){
+    if(channel > 7){
+        return PROJ_FIELD_INVALID;
+    }
+    uint8_t mask = 1 << channel;
+    if(_selected == mask){
+        return PROJ_OK;
+    }
+    for(ProjectaMux* m = _muxes; m; m = m->_nextMux){
+        if(m != this && m->_wire == _wire && m->_selected != 0){
+            if(!m->writeMask(0)){
+                return PROJ_I2C_ERROR;
+            }
+        }
+    }
+    return writeMask(mask) ? PROJ_OK : PROJ_I2C_ERROR;
+}
+
+/* Function to disconnect all channels
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR
+ */
+projecta_error ProjectaMux::deselect(){
+    if(_selected == 0){
+        return PROJ_OK;
+    }
+    return writeMask(0) ? PROJ_OK : PROJ_I2C_ERROR;
+}
+
+/* Function to forget the cached selection, e.g. after a bus
+ * error or a mux reset, so the next select() writes it again
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaMux::invalidate(){
+    _selected = PROJ_MUX_UNKNOWN;
+}
+
+/* Function to get the bus the mux sits on
+ * @input -> NULL
+ * @returns -> TwoWire reference
+ */
+TwoWire& ProjectaMux::getWire(){
+    return *_wire;
+}
+
+/* Function to get the mux address
+ * @input -> NULL
+ * @returns -> 7 bit address
+ */
+uint8_t ProjectaMux::getAddress(){
+    return _address;
+}
+
+/* Function to get the number of selection writes, to judge
+ * how well the screens are ordered
+ * @input -> NULL
+ * @returns -> channel mask writes
+ */
+uint32_t ProjectaMux::getSwitches(){
+    return _switches;
+}
@@ -0,0 +1,35 @@
+/* Projecta Library - Ben Soutter 2018
+ * TCA9548A style I2C multiplexer. Every screen answers at
+ * 0x65, so screens sharing a bus each sit on their own mux
+ * channel. The selected channel is cached and only written
+ * when it changes; selecting a channel on one mux first
+ * closes any other mux on the same bus, so two screens are
+ * never connected at once.
+ */
+#ifndef ProjectaMux_h
+#define ProjectaMux_h
+#include <Projecta.h>
+
+#define PROJ_MUX_UNKNOWN 0xFF   // Selection not known, written on next select()
+
+class ProjectaMux{
+    private:
+        TwoWire* _wire;
+        uint8_t _address;
+        uint8_t _selected = PROJ_MUX_UNKNOWN;   // channel mask last written
+        uint32_t _switches = 0;
+        ProjectaMux* _nextMux;                  // all muxes, for closing the others
+        static ProjectaMux* _muxes;
+        bool writeMask(uint8_t mask);
+    public:
+        ProjectaMux(TwoWire& wire, uint8_t address = 0x70);
+        ~ProjectaMux();
+        projecta_error select(uint8_t channel);
+        projecta_error deselect();
+        void invalidate();
+        TwoWire& getWire();
+        uint8_t getAddress();
+        uint32_t getSwitches();
+};
+
+#endif
@@ -0,0 +1,13 @@
+/* Projecta Library - Ben Soutter 2018
+ * Build-time check that the library never touches the heap.
+ * Include this last in every library source file: any later
+ * use of the allocator or of Arduino String fails to compile.
+ */
+#ifndef ProjectaNoHeap_h
+#define ProjectaNoHeap_h
+
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc strdup new String
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+#include <ProjectaProxy.h>
+#include <ProjectaNoHeap.h>
+
+ProjectaProxy::ProjectaProxy(TwoWire& charger, TwoWire& screen) : _charger(charger), _screen(screen){
+    clearOverrides();
+}
+
+/* Begin Function to start both ports: slave at 0x65 toward
+ * the charger, master toward the screen
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_I2C_ERROR (screen not answering, forwarding
+ *      starts once it does)
+ *      PROJ_LIMIT_2_EXCEEDED (no free slave slot)
+ */
+projecta_error ProjectaProxy::begin(){
+    projecta_error err = _charger.beginSlave();
+    if(err != PROJ_OK){
+        return err;
+    }
+    return _screen.begin();
+}
+
+#ifdef MULTI_I2C
+/* Begin Function to start both ports on the given pins
+ * @input -> sda and scl pins of the charger side and of the
+ * screen side
+ * @returns -> projecta_error, see begin()
+ */
+projecta_error ProjectaProxy::begin(int chargerSda, int chargerScl, int screenSda, int screenScl){
+    projecta_error err = _charger.beginSlave(chargerSda, chargerScl);
+    if(err != PROJ_OK){
+        return err;
+    }
+    return _screen.begin(screenSda, screenScl);
+}
+#endif
+
+/* Function to force bits of one frame byte. Forwarded frames
+ * get (byte & ~mask) | (value & mask); a mask of 0 passes the
+ * byte through.
+ * @input -> byte index (0-8), bits to force, their values
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_FIELD_INVALID (index is not 0-8)
+ */
+projecta_error ProjectaProxy::setOverride(uint8_t index, uint8_t mask, uint8_t value){
+    if(index > 8){
+        return PROJ_FIELD_INVALID;
+    }
+    _overrideMask[index] = mask;
+    _overrideValue[index] = value & mask;
+    return PROJ_OK;
+}
+
+/* Function to show our own value instead of the charger's
+ * (unit and digits, bytes 0-3)
+ * @input -> unit, value x1000
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_FIELD_INVALID (unit not valid)
+ */
+projecta_error ProjectaProxy::overrideValue(projecta_unit unit, int32_t milli){
+    if(unit == UNIT_NONE || unit >= UNIT_UNKNOWN){
+        return PROJ_FIELD_INVALID;
+    }
+    _valueUnit = unit;
+    _valueMilli = milli;
+    _valueOverride = true;
+    return PROJ_OK;
+}
+
+/* Function to keep the buzzer off whatever the charger sends
+ * @input -> true to mask the buzzer
+ * @returns -> ProjectaProxy reference for chaining
+ */
+ProjectaProxy& ProjectaProxy::maskBuzzer(bool mask){
+    setOverride(7, mask ? (1 << 5) : 0, 0);
+    return *this;
+}
+
+/* Function to forward frames unchanged again
+ * @input -> NULL
+ * @returns -> ProjectaProxy reference for chaining
+ */
+ProjectaProxy& ProjectaProxy::clearOverrides(){
+    memset(_overrideMask, 0, sizeof(_overrideMask));
+    memset(_overrideValue, 0, sizeof(_overrideValue));
+    _valueOverride = false;
+    return *this;
+}
+
+/* Function to apply the overrides to a frame from the
+ * charger and stage it for the screen. Frames whose checksum
+ * is wrong are dropped, as the screen would drop them.
+ * @input -> 10 byte frame
+ * @returns -> true if the frame was staged
+ */
+bool ProjectaProxy::forwardFrame(const uint8_t* frame){
+    uint8_t out[10];
+    uint8_t sum = 0;
+    for(uint8_t i=0;i<9;i++){
+        sum += frame[i];
+        out[i] = (frame[i] & ~_overrideMask[i]) | _overrideValue[i];
+    }
+    if(sum != frame[9]){
+        _rejected++;
+        return false;
+    }
+    _screen.beginUpdate();
+    _screen.setFrame(out);
+    if(_valueOverride){
+        _screen.setValueMilli(_valueUnit, _valueMilli);
+    }
+    _screen.commit();
+    _forwarded++;
+    return true;
+}
+
+/* Loop function which user must call as often as possible.
+ * Forwards the newest frame received from the charger, then
+ * makes at most one transaction toward the screen (the frame
+ * write first, otherwise a button read) and loads the latest
+ * reply for the charger's next read. Worst case forwarding
+ * latency is one call period plus one read and one write.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaProxy::loop(){
+    const projecta_capture* caps;
+    uint8_t n;
+    while((n = _charger.getCaptures(&caps)) != 0){
+        for(int8_t i=n-1; i>=0; i--){
+            if(caps[i].type == CAPTURE_FRAME && caps[i].length == 10){
+                if(forwardFrame(caps[i].data) && !_pending){
+                    _pendingMicros = caps[i].micros;
+                    _pending = true;
+                }
+                break;
+            }
+        }
+        _charger.releaseCaptures(n);
+    }
+    uint32_t sent = _screen.getFramesSent();
+    _screen.step();
+    if(_screen.getFramesSent() != sent){
+        if(_pending){
+            uint32_t latency = micros() - _pendingMicros;
+            if(latency > _maxLatency){
+                _maxLatency = latency;
+            }
+        }
+        _pending = false;
+    }else if(_pending && !_screen.isFramePending() && _screen.isConnected()){
+        _pending = false;   // frame unchanged, nothing to send
+    }
+    if(_screen.isConnected()){
+        _charger.setSlaveReply(_screen.getReply());
+    }else{
+        static const uint8_t idle[3] = {0, 0, 0};
+        _charger.setSlaveReply(idle);
+    }
+}
+
+/* Function to get the slave side object, e.g. to read the
+ * captures dropped counter
+ * @input -> NULL
+ * @returns -> Projecta reference
+ */
+Projecta& ProjectaProxy::charger(){
+    return _charger;
+}
+
+/* Function to get the master side object, e.g. to set the
+ * poll rate or a link callback
+ * @input -> NULL
+ * @returns -> Projecta reference
+ */
+Projecta& ProjectaProxy::screen(){
+    return _screen;
+}
+
+/* Function to get the number of frames forwarded
+ * @input -> NULL
+ * @returns -> frames staged for the screen
+ */
+uint32_t ProjectaProxy::getFramesForwarded(){
+    return _forwarded;
+}
+
+/* Function to get the number of frames dropped for a bad
+ * checksum
+ * @input -> NULL
+ * @returns -> frames rejected
+ */
+uint32_t ProjectaProxy::getFramesRejected(){
+    return _rejected;
+}
+
+/* Function to get the worst forwarding latency seen, from
+ * the charger's write to the end of the screen write
+ * @input -> NULL
+ * @returns -> microseconds
+ */
+uint32_t ProjectaProxy::getMaxLatency(){
+    return _maxLatency;
+}
@@ -0,0 +1,46 @@
+/* Projecta Library - Ben Soutter 2018
+ * Man-in-the-middle between a charger and its ICREMOTE
+ * screen on two I2C ports. Toward the charger the proxy is
+ * the screen (slave at 0x65); toward the screen it is the
+ * charger (master). Frames are forwarded with optional field
+ * overrides and a corrected checksum, and the screen's
+ * button reply is handed back on the charger's next read.
+ */
+#ifndef ProjectaProxy_h
+#define ProjectaProxy_h
+#include <Projecta.h>
+
+class ProjectaProxy{
+    private:
+        Projecta _charger;              // slave side
+        Projecta _screen;               // master side
+        uint8_t _overrideMask[9];
+        uint8_t _overrideValue[9];
+        bool _valueOverride = false;
+        projecta_unit _valueUnit = UNIT_NONE;
+        int32_t _valueMilli = 0;
+        uint32_t _forwarded = 0;
+        uint32_t _rejected = 0;
+        uint32_t _pendingMicros = 0;    // capture time of the frame in flight
+        bool _pending = false;
+        uint32_t _maxLatency = 0;
+        bool forwardFrame(const uint8_t* frame);
+    public:
+        ProjectaProxy(TwoWire& charger, TwoWire& screen);
+        projecta_error begin();
+        #ifdef MULTI_I2C
+        projecta_error begin(int chargerSda, int chargerScl, int screenSda, int screenScl);
+        #endif
+        projecta_error setOverride(uint8_t index, uint8_t mask, uint8_t value);
+        projecta_error overrideValue(projecta_unit unit, int32_t milli);
+        ProjectaProxy& maskBuzzer(bool mask);
+        ProjectaProxy& clearOverrides();
+        void loop();
+        Projecta& charger();
+        Projecta& screen();
+        uint32_t getFramesForwarded();
+        uint32_t getFramesRejected();
+        uint32_t getMaxLatency();
+};
+
+#endif
@@ -0,0 +1,73 @@
+/* Projecta Library - Ben Soutter 2018
+ * Fixed size single producer / single consumer ring buffer.
+ * Lock free and heap free: the producer (an interrupt or
+ * bus task) reserves and publishes slots in place, the
+ * consumer reads contiguous batches of slots without
+ * copying and releases them when done.
+ */
+#ifndef ProjectaRing_h
+#define ProjectaRing_h
+#include <Arduino.h>
+
+template<typename T, uint8_t N>
+class ProjectaRing{
+    static_assert(N && (N & (N - 1)) == 0 && N <= 128, "ring size must be a power of two <= 128");
+    private:
+        T _slots[N];
+        uint8_t _head = 0; // Only written by the producer
+        uint8_t _tail = 0; // Only written by the consumer
+        uint16_t _dropped = 0; // Only written by the producer
+    public:
+        /* Producer: get the next free slot to fill in
+         * @returns -> slot pointer, or NULL (and counts a drop)
+         * if the ring is full
+         */
+        T* reserve(){
+            uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+            if((uint8_t)(_head - tail) >= N){
+                _dropped++;
+                return NULL;
+            }
+            return &_slots[_head & (N - 1)];
+        }
+
+        /* Producer: make the slot returned by reserve()
+         * visible to the consumer
+         */
+        void publish(){
+            __atomic_store_n(&_head, (uint8_t)(_head + 1), __ATOMIC_RELEASE);
+        }
+
+        /* Consumer: get the oldest contiguous run of filled
+         * slots. A wrapped ring is returned in two batches.
+         * @returns -> number of slots available at *first
+         */
+        uint8_t peek(const T** first){
+            uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+            uint8_t idx = _tail & (N - 1);
+            uint8_t n = head - _tail;
+            if(n > N - idx){
+                n = N - idx;
+            }
+            *first = &_slots[idx];
+            return n;
+        }
+
+        /* Consumer: hand n slots from peek() back to the producer */
+        void release(uint8_t n){
+            __atomic_store_n(&_tail, (uint8_t)(_tail + n), __ATOMIC_RELEASE);
+        }
+
+        uint8_t size(){
+            return (uint8_t)(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) - _tail);
+        }
+
+        uint16_t dropped(){
+            noInterrupts();
+            uint16_t d = _dropped;
+            interrupts();
+            return d;
+        }
+};
+
+#endif
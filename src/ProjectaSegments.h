@@ -0,0 +1,151 @@
+/* Projecta Library - Ben Soutter 2018
+ * Seven segment glyphs and unit symbol codes of the
+ * ICREMOTE screen, shared by the frame encoder and the
+ * decoder. Everything here is constexpr so it can be
+ * evaluated at compile time.
+ */
+#ifndef ProjectaSegments_h
+#define ProjectaSegments_h
+#include <stdint.h>
+
+#define PROJ_SEG_DP 0x10    // Decimal point bit in digit bytes 2 and 3
+#define PROJ_SEG_DASH 0x04  // '-' shown when a number does not fit
+
+// Segment bits of a digit byte, a is the top bar and g the
+// middle one, clockwise from a as on any seven segment
+#define PROJ_SEG_A 0x80
+#define PROJ_SEG_B 0x40
+#define PROJ_SEG_C 0x20
+#define PROJ_SEG_D 0x01
+#define PROJ_SEG_E 0x02
+#define PROJ_SEG_F 0x08
+#define PROJ_SEG_G 0x04
+
+#define PROJ_GLYPH_INVALID 0xFF // No glyph for the character
+
+// Unit symbol codes (frame byte 0)
+#define PROJ_UNIT_CODE_VOLT 0x08
+#define PROJ_UNIT_CODE_AMP 0x80
+#define PROJ_UNIT_CODE_WATT 0x20
+#define PROJ_UNIT_CODE_KILOWATT 0x22
+#define PROJ_UNIT_CODE_CELSIUS 0x04
+#define PROJ_UNIT_CODE_PERCENT 0x40
+#define PROJ_UNIT_CODE_AMP_HOUR 0x11
+#define PROJ_UNIT_CODE_WATT_HOUR 0x30
+#define PROJ_UNIT_CODE_KILOWATT_HOUR 0x32
+#define PROJ_UNIT_CODE_HOUR 0x01
+
+typedef enum{
+    UNIT_NONE = 0,
+    UNIT_VOLT,
+    UNIT_AMP,
+    UNIT_WATT,
+    UNIT_KILOWATT,
+    UNIT_CELSIUS,
+    UNIT_PERCENT,
+    UNIT_AMP_HOUR,
+    UNIT_WATT_HOUR,
+    UNIT_KILOWATT_HOUR,
+    UNIT_HOUR,
+    UNIT_UNKNOWN
+}projecta_unit;
+
+/* Digit (0-9) -> segment pattern */
+constexpr uint8_t projectaDigitSegments(uint8_t d){
+    return d == 0 ? 0xEB : d == 1 ? 0x60 : d == 2 ? 0xC7 : d == 3 ? 0xE5 :
+           d == 4 ? 0x6C : d == 5 ? 0xAD : d == 6 ? 0xAF : d == 7 ? 0xE0 :
+           d == 8 ? 0xEF : d == 9 ? 0xED : 0x00;
+}
+
+/* Segment pattern (decimal point masked off) -> digit,
+ * 0xFF if the pattern is not a digit
+ */
+constexpr uint8_t projectaSegmentsDigit(uint8_t seg){
+    return seg == 0xEB ? 0 : seg == 0x60 ? 1 : seg == 0xC7 ? 2 : seg == 0xE5 ? 3 :
+           seg == 0x6C ? 4 : seg == 0xAD ? 5 : seg == 0xAF ? 6 : seg == 0xE0 ? 7 :
+           seg == 0xEF ? 8 : seg == 0xED ? 9 : 0xFF;
+}
+
+/* Letter (a-z) -> segment pattern */
+constexpr uint8_t projectaLetterSegments(uint8_t l){
+    return l == 'a' ? 0xEE : l == 'b' ? 0x2F : l == 'c' ? 0x8B : l == 'd' ? 0x67 :
+           l == 'e' ? 0x8F : l == 'f' ? 0x8E : l == 'g' ? 0xED : l == 'h' ? 0x2E :
+           l == 'i' ? 0x0A : l == 'j' ? 0x63 : l == 'k' ? 0x6E : l == 'l' ? 0x0B :
+           l == 'm' ? 0xA2 : l == 'n' ? 0x26 : l == 'o' ? 0xEB : l == 'p' ? 0xCE :
+           l == 'q' ? 0xEC : l == 'r' ? 0x06 : l == 's' ? 0xAD : l == 't' ? 0x0F :
+           l == 'u' ? 0x6B : l == 'v' ? 0x23 : l == 'w' ? 0x49 : l == 'x' ? 0x6E :
+           l == 'y' ? 0x6D : l == 'z' ? 0xC7 : PROJ_GLYPH_INVALID;
+}
+
+/* Punctuation -> segment pattern. '.' is the decimal point on
+ * its own; encoders fold it into the previous glyph instead.
+ * '*' is the degree sign.
+ */
+constexpr uint8_t projectaSymbolSegments(uint8_t c){
+    return c == ' ' ? 0x00 :
+           c == '.' || c == ',' ? PROJ_SEG_DP :
+           c == '-' ? PROJ_SEG_G :
+           c == '_' ? PROJ_SEG_D :
+           c == '=' ? (PROJ_SEG_G | PROJ_SEG_D) :
+           c == '\'' ? PROJ_SEG_F :
+           c == '"' ? (PROJ_SEG_B | PROJ_SEG_F) :
+           c == '*' ? (PROJ_SEG_A | PROJ_SEG_B | PROJ_SEG_F | PROJ_SEG_G) :
+           c == '^' ? (PROJ_SEG_A | PROJ_SEG_B | PROJ_SEG_F) :
+           c == '[' || c == '(' ? (PROJ_SEG_A | PROJ_SEG_D | PROJ_SEG_E | PROJ_SEG_F) :
+           c == ']' || c == ')' ? (PROJ_SEG_A | PROJ_SEG_B | PROJ_SEG_C | PROJ_SEG_D) :
+           c == '/' ? (PROJ_SEG_B | PROJ_SEG_G | PROJ_SEG_E) :
+           c == '\\' ? (PROJ_SEG_F | PROJ_SEG_G | PROJ_SEG_C) :
+           c == '?' ? (PROJ_SEG_A | PROJ_SEG_B | PROJ_SEG_G | PROJ_SEG_E) :
+           PROJ_GLYPH_INVALID;
+}
+
+/* ASCII character -> segment pattern, PROJ_GLYPH_INVALID if
+ * the screen cannot show it. Upper and lower case share the
+ * same glyph.
+ */
+constexpr uint8_t projectaGlyphSegments(uint8_t c){
+    return c >= '0' && c <= '9' ? projectaDigitSegments(c - '0') :
+           c >= 'a' && c <= 'z' ? projectaLetterSegments(c) :
+           c >= 'A' && c <= 'Z' ? projectaLetterSegments(c + 32) :
+           projectaSymbolSegments(c);
+}
+
+/* projecta_unit -> frame byte 0 */
+constexpr uint8_t projectaUnitCode(uint8_t unit){
+    return unit == UNIT_VOLT ? PROJ_UNIT_CODE_VOLT :
+           unit == UNIT_AMP ? PROJ_UNIT_CODE_AMP :
+           unit == UNIT_WATT ? PROJ_UNIT_CODE_WATT :
+           unit == UNIT_KILOWATT ? PROJ_UNIT_CODE_KILOWATT :
+           unit == UNIT_CELSIUS ? PROJ_UNIT_CODE_CELSIUS :
+           unit == UNIT_PERCENT ? PROJ_UNIT_CODE_PERCENT :
+           unit == UNIT_AMP_HOUR ? PROJ_UNIT_CODE_AMP_HOUR :
+           unit == UNIT_WATT_HOUR ? PROJ_UNIT_CODE_WATT_HOUR :
+           unit == UNIT_KILOWATT_HOUR ? PROJ_UNIT_CODE_KILOWATT_HOUR :
+           unit == UNIT_HOUR ? PROJ_UNIT_CODE_HOUR : 0x00;
+}
+
+/* Frame byte 0 -> projecta_unit */
+constexpr uint8_t projectaCodeUnit(uint8_t code){
+    return code == 0x00 ? UNIT_NONE :
+           code == PROJ_UNIT_CODE_VOLT ? UNIT_VOLT :
+           code == PROJ_UNIT_CODE_AMP ? UNIT_AMP :
+           code == PROJ_UNIT_CODE_WATT ? UNIT_WATT :
+           code == PROJ_UNIT_CODE_KILOWATT ? UNIT_KILOWATT :
+           code == PROJ_UNIT_CODE_CELSIUS ? UNIT_CELSIUS :
+           code == PROJ_UNIT_CODE_PERCENT ? UNIT_PERCENT :
+           code == PROJ_UNIT_CODE_AMP_HOUR ? UNIT_AMP_HOUR :
+           code == PROJ_UNIT_CODE_WATT_HOUR ? UNIT_WATT_HOUR :
+           code == PROJ_UNIT_CODE_KILOWATT_HOUR ? UNIT_KILOWATT_HOUR :
+           code == PROJ_UNIT_CODE_HOUR ? UNIT_HOUR : UNIT_UNKNOWN;
+}
+
+/* Expand f(0) ... f(255) to build 128 or 256 entry lookup tables
+ * from a constexpr function
+ */
+#define PROJ_TABLE4(f, n) f(n), f((n) + 1), f((n) + 2), f((n) + 3)
+#define PROJ_TABLE16(f, n) PROJ_TABLE4(f, n), PROJ_TABLE4(f, (n) + 4), PROJ_TABLE4(f, (n) + 8), PROJ_TABLE4(f, (n) + 12)
+#define PROJ_TABLE64(f, n) PROJ_TABLE16(f, n), PROJ_TABLE16(f, (n) + 16), PROJ_TABLE16(f, (n) + 32), PROJ_TABLE16(f, (n) + 48)
+#define PROJ_TABLE128(f) PROJ_TABLE64(f, 0), PROJ_TABLE64(f, 64)
+#define PROJ_TABLE256(f) PROJ_TABLE64(f, 0), PROJ_TABLE64(f, 64), PROJ_TABLE64(f, 128), PROJ_TABLE64(f, 192)
+
+#endif
@@ -0,0 +1,68 @@
+/* Projecta Library - Ben Soutter 2018
+ * Histogram and dump helpers for PROJECTA_STATS builds.
+ */
+#include <ProjectaStats.h>
+
+#if PROJECTA_STATS
+#include <ProjectaNoHeap.h>
+
+/* Function to add one duration to a log2 histogram
+ * @input -> histogram, duration in microseconds
+ * @returns -> NULL
+ */
+void projectaStatsRecord(projecta_histogram& hist, uint32_t us){
+    uint8_t bucket = 0;
+    while(us && bucket < PROJECTA_STATS_BUCKETS - 1){
+        us >>= 1;
+        bucket++;
+    }
+    hist.count[bucket]++;
+}
+
+/* Function to print one histogram as "<us:count" pairs
+ * (bucket upper bound, ">=us" for the last bucket, which
+ * has no upper bound), skipping empty buckets
+ * @input -> label, histogram, output
+ * @returns -> NULL
+ */
+static void dumpHistogram(const __FlashStringHelper* name, const projecta_histogram& hist, Print& out){
+    out.print(name);
+    for(uint8_t i=0;i<PROJECTA_STATS_BUCKETS;i++){
+        if(!hist.count[i]){
+            continue;
+        }
+        out.print(' ');
+        if(i == PROJECTA_STATS_BUCKETS - 1){
+            out.print(F(">="));
+            out.print(1UL << (i - 1));
+        }else{
+            out.print('<');
+            out.print(1UL << i);
+        }
+        out.print(':');
+        out.print((unsigned long)hist.count[i]);
+    }
+    out.println();
+}
+
+/* Function to print a stats block: one line of counters
+ * followed by one line per histogram
+ * @input -> stats, output (e.g. Serial)
+ * @returns -> NULL
+ */
+void projectaStatsDump(const projecta_stats& stats, Print& out){
+    out.print(F("tx "));
+    out.print((unsigned long)stats.transactions);
+    out.print(F(" nack "));
+    out.print((unsigned long)stats.nacks);
+    out.print(F(" short "));
+    out.print((unsigned long)stats.shortReads);
+    out.print(F(" csum "));
+    out.print((unsigned long)stats.checksumMismatches);
+    out.println();
+    dumpHistogram(F("read "), stats.read, out);
+    dumpHistogram(F("write"), stats.write, out);
+    dumpHistogram(F("loop "), stats.loop, out);
+}
+
+#endif
@@ -0,0 +1,44 @@
+/* Projecta Library - Ben Soutter 2018
+ * Optional runtime instrumentation. Built with
+ * -DPROJECTA_STATS=1 every Projecta object keeps bus error
+ * counters and log2 bucketed micros() histograms of its read
+ * phase, write phase and service calls. Without it the
+ * PROJ_STATS() hooks expand to nothing.
+ */
+#ifndef ProjectaStats_h
+#define ProjectaStats_h
+#include <Arduino.h>
+#include <ProjectaConfig.h>
+
+#if PROJECTA_STATS
+
+#define PROJ_STATS(...) __VA_ARGS__
+#define PROJ_STATS_START(var) uint32_t var = micros()
+
+/* Bucket 0 counts 0 us, bucket n counts 2^(n-1) to 2^n - 1 us
+ * and the last bucket everything from 2^(n-1) up */
+typedef struct{
+    uint32_t count[PROJECTA_STATS_BUCKETS];
+}projecta_histogram;
+
+typedef struct{
+    uint32_t transactions;          // reads, writes and probes started
+    uint32_t nacks;                 // transactions the screen did not acknowledge
+    uint32_t shortReads;            // button reads returning 1-2 bytes
+    uint32_t checksumMismatches;    // frames whose byte 9 is not the sum of 0-8
+    projecta_histogram read;        // pollButtons() duration
+    projecta_histogram write;       // sendFrame() duration
+    projecta_histogram loop;        // loop() / step() duration
+}projecta_stats;
+
+void projectaStatsRecord(projecta_histogram& hist, uint32_t us);
+void projectaStatsDump(const projecta_stats& stats, Print& out);
+
+#else
+
+#define PROJ_STATS(...)
+#define PROJ_STATS_START(var)
+
+#endif
+
+#endif
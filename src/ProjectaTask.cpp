@@ -0,0 +1,195 @@
+/* Projecta Library - Ben Soutter 2018
+ * Optional bus task. Once started it owns all bus I/O of its
+ * object: frames arrive from commit() through a lock free
+ * mailbox, button events leave through the event ring, and
+ * loop()/step() in the application no longer touch the bus.
+ * ESP32 builds use a pinned FreeRTOS task with a static
+ * stack; the host build uses a std::thread so the same
+ * concurrency can be stress tested on Linux.
+ */
+#include <Projecta.h>
+
+#if PROJECTA_BUS_TASK
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(PROJECTA_HOST)
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#else
+#error "PROJECTA_BUS_TASK needs ESP32 (FreeRTOS) or the host build"
+#endif
+#include <ProjectaNoHeap.h>
+
+static Projecta* _taskOwners[PROJECTA_MAX_TASKS];
+
+#if defined(ESP32)
+static StaticTask_t _taskBuffers[PROJECTA_MAX_TASKS];
+static StackType_t _taskStacks[PROJECTA_MAX_TASKS][PROJECTA_TASK_STACK];
+static TaskHandle_t _taskHandles[PROJECTA_MAX_TASKS];
+static bool _taskExited[PROJECTA_MAX_TASKS];   // parked, ready to be deleted
+#else
+static std::thread _taskThreads[PROJECTA_MAX_TASKS];
+static std::mutex _taskLocks[PROJECTA_MAX_TASKS];
+static std::condition_variable _taskWake[PROJECTA_MAX_TASKS];
+static bool _taskKick[PROJECTA_MAX_TASKS];
+#endif
+
+#define PROJ_TASK_MAX_SLEEP_MS 100
+
+/* Function to wake the bus task early, after a commit().
+ * Uses xTaskNotifyGive(), so commit() must not be called
+ * from an interrupt while the task runs.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::wakeBusTask(void){
+    int8_t slot = _taskSlot;
+    #if defined(ESP32)
+    xTaskNotifyGive(_taskHandles[slot]);
+    #else
+    {
+        std::lock_guard<std::mutex> lock(_taskLocks[slot]);
+        _taskKick[slot] = true;
+    }
+    _taskWake[slot].notify_one();
+    #endif
+}
+
+/* Bus task body: do the due bus work, then sleep until the
+ * next deadline or until commit() posts a frame
+ */
+void Projecta::busTaskMain(void* arg){
+    Projecta* proj = static_cast<Projecta*>(arg);
+    int8_t slot = proj->_taskSlot;
+    while(__atomic_load_n(&proj->_taskRun, __ATOMIC_ACQUIRE)){
+        uint32_t deadline = proj->serviceBus();
+        int32_t wait = (int32_t)(deadline - millis());
+        if(wait > PROJ_TASK_MAX_SLEEP_MS){
+            wait = PROJ_TASK_MAX_SLEEP_MS;
+        }
+        #if defined(ESP32)
+        if(wait > 0){
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        }else{
+            taskYIELD();
+        }
+        #else
+        if(wait > 0){
+            std::unique_lock<std::mutex> lock(_taskLocks[slot]);
+            _taskWake[slot].wait_for(lock, std::chrono::milliseconds(wait), [slot]{ return _taskKick[slot]; });
+            _taskKick[slot] = false;
+        }else{
+            std::this_thread::yield();
+        }
+        #endif
+    }
+    #if defined(ESP32)
+    // Park rather than delete itself: stopBusTask() deletes
+    // the task once it is blocked, so the static stack and
+    // TCB are free as soon as it returns
+    __atomic_store_n(&_taskExited[slot], true, __ATOMIC_RELEASE);
+    for(;;){
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    #else
+    (void)slot;
+    #endif
+}
+
+/* Function to start a task that owns this object's bus. From
+ * then on setters only post frames to the task, loop() and
+ * step() only service pages and callbacks, and the link
+ * callback runs on the task.
+ * @input -> core to pin to and FreeRTOS priority (ESP32
+ * only, ignored on the host)
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_LIMIT_2_EXCEEDED (no bus, slave mode, behind a
+ *      mux, or PROJECTA_MAX_TASKS already running)
+ */
+projecta_error Projecta::startBusTask(uint8_t core, uint8_t priority){
+    if(_taskSlot >= 0){
+        return PROJ_OK;
+    }
+    if(!_wire || _mux || _proj_mode == PROJECTA_SLAVE){   // muxed screens share their bus
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    int8_t slot = -1;
+    for(uint8_t i=0;i<PROJECTA_MAX_TASKS;i++){
+        if(!_taskOwners[i]){
+            slot = i;
+            break;
+        }
+    }
+    if(slot < 0){
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    snapshotFrame(_mailbox.write().bytes);
+    _mailbox.publish();
+    _taskOwners[slot] = this;
+    _taskSlot = slot;
+    __atomic_store_n(&_taskRun, true, __ATOMIC_RELEASE);
+    #if defined(ESP32)
+    __atomic_store_n(&_taskExited[slot], false, __ATOMIC_RELEASE);
+    _taskHandles[slot] = xTaskCreateStaticPinnedToCore(busTaskMain, "projecta", PROJECTA_TASK_STACK,
+        this, priority, _taskStacks[slot], &_taskBuffers[slot], core);
+    if(!_taskHandles[slot]){
+        _taskOwners[slot] = NULL;
+        _taskSlot = -1;
+        _taskRun = false;
+        return PROJ_LIMIT_2_EXCEEDED;
+    }
+    #else
+    (void)core;
+    (void)priority;
+    _taskKick[slot] = false;
+    _taskThreads[slot] = std::thread(busTaskMain, this);
+    #endif
+    return PROJ_OK;
+}
+
+/* Function to stop the bus task and hand the bus back to
+ * loop()/step(). Waits for the task's current transaction,
+ * and on ESP32 deletes the parked task before its stack
+ * slot can be reused.
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void Projecta::stopBusTask(){
+    int8_t slot = _taskSlot;
+    if(slot < 0){
+        return;
+    }
+    __atomic_store_n(&_taskRun, false, __ATOMIC_RELEASE);
+    wakeBusTask();
+    #if defined(ESP32)
+    while(!__atomic_load_n(&_taskExited[slot], __ATOMIC_ACQUIRE)){
+        vTaskDelay(1);
+    }
+    eTaskState state = eTaskGetState(_taskHandles[slot]);
+    while(state == eRunning || state == eReady){
+        vTaskDelay(1);
+        state = eTaskGetState(_taskHandles[slot]);
+    }
+    vTaskDelete(_taskHandles[slot]);   // Blocked, so freed at once
+    _taskHandles[slot] = NULL;
+    #else
+    _taskThreads[slot].join();
+    #endif
+    _taskOwners[slot] = NULL;
+    _taskSlot = -1;
+    _frameDirty = true;
+}
+
+/* Function to check whether the bus task is running
+ * @input -> NULL
+ * @returns -> true between startBusTask() and stopBusTask()
+ */
+bool Projecta::isBusTaskRunning(){
+    return _taskSlot >= 0;
+}
+
+#endif
@@ -0,0 +1,302 @@
+#include <ProjectaTelemetry.h>
+#include <ProjectaNoHeap.h>
+
+/* CRC-8, polynomial 0x07, of one byte */
+static constexpr uint8_t crcShift(uint8_t c, uint8_t bits){
+    return bits == 0 ? c : crcShift((c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1), bits - 1);
+}
+
+static constexpr uint8_t crcEntry(uint8_t b){
+    return crcShift(b, 8);
+}
+
+static const uint8_t _crcTable[256] PROGMEM = { PROJ_TABLE256(crcEntry) };
+static const int16_t _decimalScale[3] = {1000, 100, 10};
+
+/* Function to get the CRC-8 of a run of bytes
+ * @input -> bytes, length
+ * @returns -> CRC
+ */
+static uint8_t crc8(const uint8_t* data, size_t len){
+    uint8_t crc = 0;
+    for(size_t i=0;i<len;i++){
+        crc = pgm_read_byte(&_crcTable[crc ^ data[i]]);
+    }
+    return crc;
+}
+
+/* Function to append an unsigned LEB128 varint
+ * @input -> value, buffer with at least 5 bytes free
+ * @returns -> bytes used
+ */
+static uint8_t putVarint(uint32_t value, uint8_t* out){
+    uint8_t n = 0;
+    while(value >= 0x80){
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+ProjectaTelemetryWriter::ProjectaTelemetryWriter(Print& out){
+    _out = &out;
+    memset(&_last, 0, sizeof(_last));
+}
+
+/* Function to set how often a full record is sent, which
+ * bounds how long a reader that lost bytes stays blind
+ * @input -> records between keyframes (0 = every record)
+ * @returns -> ProjectaTelemetryWriter&
+ */
+ProjectaTelemetryWriter& ProjectaTelemetryWriter::setKeyframeInterval(uint16_t records){
+    _keyInterval = records;
+    return *this;
+}
+
+/* Function to make the next record a keyframe, e.g. after
+ * the serial port was reopened
+ * @input -> NULL
+ * @returns -> NULL
+ */
+void ProjectaTelemetryWriter::forceKeyframe(){
+    _sinceKey = 0xFFFF;
+}
+
+/* Function to log the screen state. Only the fields that
+ * changed since the previous record are written, unless a
+ * keyframe is due. The record goes out in one write.
+ * @input -> timestamp (micros), decoded frame
+ * @returns -> bytes written
+ */
+size_t ProjectaTelemetryWriter::writeTelemetry(uint32_t micros, const projecta_telemetry& tel){
+    uint8_t record[PROJ_TELEMETRY_MAX_RECORD];
+    uint8_t leds = tel.leds | (tel.buzzer ? 0x20 : 0x00);
+    uint8_t lastLeds = _last.leds | (_last.buzzer ? 0x20 : 0x00);
+    uint8_t tag = tel.checksumValid ? PROJ_TELEMETRY_CHECKSUM : 0x00;
+    if(_sinceKey >= _keyInterval){
+        tag |= PROJ_TELEMETRY_KEYFRAME | PROJ_TELEMETRY_FIELDS;
+        _sinceKey = 0;
+    }else{
+        _sinceKey++;
+        if(tel.raw != _last.raw || tel.decimals != _last.decimals){
+            tag |= PROJ_TELEMETRY_VALUE;
+        }
+        if(tel.unit != _last.unit){
+            tag |= PROJ_TELEMETRY_UNIT;
+        }
+        if(tel.battery != _last.battery){
+            tag |= PROJ_TELEMETRY_BATTERY;
+        }
+        if(tel.bar != _last.bar){
+            tag |= PROJ_TELEMETRY_BAR;
+        }
+        if(leds != lastLeds){
+            tag |= PROJ_TELEMETRY_LEDS;
+        }
+    }
+    uint8_t n = 0;
+    record[n++] = PROJ_TELEMETRY_SYNC;
+    record[n++] = tag;
+    if(tag & PROJ_TELEMETRY_KEYFRAME){
+        n += putVarint(micros, &record[n]);
+        _lastDt = 0;
+    }else{
+        int32_t change = (int32_t)(micros - _lastMicros - _lastDt);
+        n += putVarint((uint32_t)(change << 1) ^ (uint32_t)(change >> 31), &record[n]);
+        _lastDt = micros - _lastMicros;
+    }
+    if(tag & PROJ_TELEMETRY_VALUE){
+        n += putVarint((uint32_t)(tel.raw + 1) * 4 + tel.decimals, &record[n]);
+    }
+    if(tag & PROJ_TELEMETRY_UNIT){
+        record[n++] = tel.unit;
+    }
+    if(tag & PROJ_TELEMETRY_BATTERY){
+        record[n++] = tel.battery;
+    }
+    if(tag & PROJ_TELEMETRY_BAR){
+        record[n++] = tel.bar;
+    }
+    if(tag & PROJ_TELEMETRY_LEDS){
+        record[n++] = leds;
+    }
+    record[n] = crc8(&record[1], n - 1);
+    n++;
+    _last = tel;
+    _lastMicros = micros;
+    size_t written = _out->write(record, n);
+    _bytes += written;
+    return written;
+}
+
+/* Function to log a raw display frame, see writeTelemetry()
+ * @input -> timestamp (micros), 10 byte frame
+ * @returns -> bytes written
+ */
+size_t ProjectaTelemetryWriter::writeFrame(uint32_t micros, const uint8_t* frame){
+    projecta_telemetry tel;
+    projectaDecodeFrame(frame, tel);
+    return writeTelemetry(micros, tel);
+}
+
+/* Function to log a transfer captured in slave mode. Button
+ * replies and frames of the wrong length are not logged.
+ * @input -> capture from getCaptures()
+ * @returns -> bytes written
+ */
+size_t ProjectaTelemetryWriter::writeCapture(const projecta_capture& capture){
+    if(capture.type != CAPTURE_FRAME || capture.length != 10){
+        return 0;
+    }
+    return writeFrame(capture.micros, capture.data);
+}
+
+/* Function to get the size of the log so far
+ * @input -> NULL
+ * @returns -> bytes written
+ */
+size_t ProjectaTelemetryWriter::getBytesWritten(){
+    return _bytes;
+}
+
+ProjectaTelemetryReader::ProjectaTelemetryReader(const uint8_t* data, size_t length){
+    _data = data;
+    _length = length;
+    memset(&_state, 0, sizeof(_state));
+}
+
+bool ProjectaTelemetryReader::readVarint(size_t& pos, uint32_t& value){
+    value = 0;
+    for(uint8_t shift=0; shift<35; shift+=7){
+        if(pos >= _length){
+            return false;
+        }
+        uint8_t b = _data[pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Function to decode the next record into the full state.
+ * A record with a bad CRC is skipped byte by byte until the
+ * next good one, and records after it are dropped until a
+ * keyframe restores every field.
+ * @input -> timestamp and state to fill in
+ * @returns -> false at the end of the log (or of the bytes
+ * received so far, if the last record is incomplete)
+ */
+bool ProjectaTelemetryReader::next(uint32_t& micros, projecta_telemetry& out){
+    while(_pos < _length){
+        if(_data[_pos] != PROJ_TELEMETRY_SYNC){
+            if(_synced){
+                _errors++;      // Bytes between records, one may be lost
+                _synced = false;
+            }
+            _pos++;
+            continue;
+        }
+        size_t pos = _pos + 1;
+        if(pos >= _length){
+            return false;
+        }
+        uint8_t tag = _data[pos++];
+        uint32_t time, value = 0;
+        uint8_t fields[4];
+        bool ok = readVarint(pos, time);
+        if(ok && (tag & PROJ_TELEMETRY_VALUE)){
+            ok = readVarint(pos, value);
+        }
+        uint8_t n = 0;
+        for(uint8_t bit=PROJ_TELEMETRY_UNIT; ok && bit<=PROJ_TELEMETRY_LEDS; bit<<=1){
+            if(tag & bit){
+                ok = pos < _length;
+                fields[n++] = ok ? _data[pos++] : 0;
+            }
+        }
+        if(!ok || pos >= _length){
+            if(_length - _pos >= PROJ_TELEMETRY_MAX_RECORD){
+                _errors++;      // A varint that never ends
+                _synced = false;
+                _pos++;
+                continue;
+            }
+            return false;       // Incomplete, wait for more bytes
+        }
+        uint8_t keyframe = tag & PROJ_TELEMETRY_KEYFRAME;
+        if(crc8(&_data[_pos + 1], pos - _pos - 1) != _data[pos] || (tag & 0x20) ||
+            (keyframe && (tag & PROJ_TELEMETRY_FIELDS) != PROJ_TELEMETRY_FIELDS) ||
+            value > 1000 * 4 + 2 || (value & 3) == 3){
+            _errors++;
+            _synced = false;
+            _pos++;
+            continue;
+        }
+        _pos = pos + 1;
+        if(!keyframe && !_synced){
+            _skipped++;
+            continue;
+        }
+        _synced = true;
+        if(keyframe){
+            _micros = time;
+            _lastDt = 0;
+        }else{
+            _lastDt += (time >> 1) ^ (0 - (time & 1));
+            _micros += _lastDt;
+        }
+        if(tag & PROJ_TELEMETRY_VALUE){
+            _state.raw = (int16_t)(value >> 2) - 1;
+            _state.decimals = value & 3;
+            _state.milli = _state.raw < 0 ? 0 : (int32_t)_state.raw * _decimalScale[_state.decimals];
+        }
+        n = 0;
+        if(tag & PROJ_TELEMETRY_UNIT){
+            _state.unit = fields[n++];
+        }
+        if(tag & PROJ_TELEMETRY_BATTERY){
+            _state.battery = fields[n++];
+        }
+        if(tag & PROJ_TELEMETRY_BAR){
+            _state.bar = fields[n++];
+        }
+        if(tag & PROJ_TELEMETRY_LEDS){
+            _state.leds = fields[n] & 0x1F;
+            _state.buzzer = fields[n] & 0x20;
+        }
+        _state.checksumValid = tag & PROJ_TELEMETRY_CHECKSUM;
+        micros = _micros;
+        out = _state;
+        return true;
+    }
+    return false;
+}
+
+/* Function to get the number of damaged records seen
+ * @input -> NULL
+ * @returns -> sync bytes that did not start a good record
+ */
+uint32_t ProjectaTelemetryReader::getErrors(){
+    return _errors;
+}
+
+/* Function to get the number of good records dropped while
+ * waiting for a keyframe after damage
+ * @input -> NULL
+ * @returns -> records dropped
+ */
+uint32_t ProjectaTelemetryReader::getSkipped(){
+    return _skipped;
+}
+
+/* Function to get the read offset. When decoding a live
+ * serial feed, bytes before it can be discarded.
+ * @input -> NULL
+ * @returns -> offset of the next record
+ */
+size_t ProjectaTelemetryReader::getPosition(){
+    return _pos;
+}
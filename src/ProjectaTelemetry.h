@@ -0,0 +1,84 @@
+/* Projecta Library - Ben Soutter 2018
+ * Compact binary log of the screen state, small enough to
+ * send every frame over a 115200 baud UART. Where a trace
+ * (ProjectaTrace.h) keeps the raw bytes, this keeps the
+ * decoded fields and only those that changed.
+ *
+ * Each record is:
+ *   0xA5 sync byte
+ *   tag: bit 7 keyframe, bit 6 frame checksum was valid,
+ *        bits 4:0 fields present (bit 5 is always 0)
+ *   varint time: absolute micros in a keyframe, otherwise
+ *        the change in the interval between records, zigzag
+ *        coded (unsigned LEB128), so a steady frame rate
+ *        costs one byte
+ *   fields present, in bit order:
+ *        bit 0 value, varint (raw + 1) * 4 + decimals
+ *        bit 1 unit (projecta_unit)
+ *        bit 2 battery (projecta_battery_type)
+ *        bit 3 bar level
+ *        bit 4 LEDs, bit 5 = buzzer
+ *   CRC-8 (poly 0x07) of the tag to the last field
+ * A keyframe carries every field, so a reader that lost
+ * bytes skips to the next sync byte with a good CRC and
+ * resumes at the next keyframe. Records must follow each
+ * other with no bytes between them; a gap also counts as
+ * damage. An unchanged frame at a steady rate takes 4 bytes.
+ */
+#ifndef ProjectaTelemetry_h
+#define ProjectaTelemetry_h
+#include <ProjectaDecoder.h>
+
+#define PROJ_TELEMETRY_SYNC 0xA5
+#define PROJ_TELEMETRY_KEYFRAME 0x80
+#define PROJ_TELEMETRY_CHECKSUM 0x40
+#define PROJ_TELEMETRY_VALUE 0x01
+#define PROJ_TELEMETRY_UNIT 0x02
+#define PROJ_TELEMETRY_BATTERY 0x04
+#define PROJ_TELEMETRY_BAR 0x08
+#define PROJ_TELEMETRY_LEDS 0x10
+#define PROJ_TELEMETRY_FIELDS 0x1F
+#define PROJ_TELEMETRY_MAX_RECORD 14    // sync + tag + 5 byte varint + 2 byte value + 4 fields + CRC
+
+/* Writes the log to any Print, usually Serial */
+class ProjectaTelemetryWriter{
+    private:
+        Print* _out;
+        projecta_telemetry _last;
+        uint32_t _lastMicros = 0;
+        uint32_t _lastDt = 0;
+        uint16_t _keyInterval = 50;
+        uint16_t _sinceKey = 0xFFFF;    // first record is a keyframe
+        size_t _bytes = 0;
+    public:
+        ProjectaTelemetryWriter(Print& out);
+        ProjectaTelemetryWriter& setKeyframeInterval(uint16_t records);
+        void forceKeyframe();
+        size_t writeTelemetry(uint32_t micros, const projecta_telemetry& tel);
+        size_t writeFrame(uint32_t micros, const uint8_t* frame);
+        size_t writeCapture(const projecta_capture& capture);
+        size_t getBytesWritten();
+};
+
+/* Rebuilds the full state from a log held in memory */
+class ProjectaTelemetryReader{
+    private:
+        const uint8_t* _data;
+        size_t _length;
+        size_t _pos = 0;
+        projecta_telemetry _state;
+        uint32_t _micros = 0;
+        uint32_t _lastDt = 0;
+        bool _synced = false;
+        uint32_t _errors = 0;
+        uint32_t _skipped = 0;
+        bool readVarint(size_t& pos, uint32_t& value);
+    public:
+        ProjectaTelemetryReader(const uint8_t* data, size_t length);
+        bool next(uint32_t& micros, projecta_telemetry& out);
+        uint32_t getErrors();
+        uint32_t getSkipped();
+        size_t getPosition();
+};
+
+#endif
@@ -0,0 +1,270 @@
+#include <ProjectaTrace.h>
+#include <ProjectaNoHeap.h>
+
+static const uint8_t _traceMagic[4] = {'P', 'J', 'T', 'R'};
+
+/* Function to append an unsigned LEB128 varint
+ * @input -> value, buffer with at least 5 bytes free
+ * @returns -> bytes used
+ */
+static uint8_t putVarint(uint32_t value, uint8_t* out){
+    uint8_t n = 0;
+    while(value >= 0x80){
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+ProjectaTraceWriter::ProjectaTraceWriter(Print& out){
+    _out = &out;
+    memset(_frame, 0, sizeof(_frame));
+    memset(_reply, 0, sizeof(_reply));
+    _lastMicros = 0;
+    _bytes = 0;
+}
+
+/* Function to start a trace: writes the header and resets
+ * the delta state
+ * @input -> micros() at the start of the trace
+ * @returns -> bytes written
+ */
+size_t ProjectaTraceWriter::begin(uint32_t micros){
+    uint8_t header[PROJ_TRACE_HEADER_SIZE];
+    memcpy(header, _traceMagic, 4);
+    header[4] = PROJ_TRACE_VERSION;
+    memset(_frame, 0, sizeof(_frame));
+    memset(_reply, 0, sizeof(_reply));
+    _lastMicros = micros;
+    size_t n = _out->write(header, sizeof(header));
+    _bytes += n;
+    return n;
+}
+
+/* Function to write one record: tag, timestamp, `used` extra
+ * header bytes (the high mask bits of a frame), then the
+ * data bytes. The record goes out in one write so SD cards
+ * see whole records.
+ * @input -> tag, timestamp, data, extra header bytes
+ * @returns -> bytes written
+ */
+size_t ProjectaTraceWriter::emit(uint8_t tag, uint32_t micros, const uint8_t* data, uint8_t len, const uint8_t* extra, uint8_t used){
+    uint8_t record[PROJ_TRACE_MAX_RECORD];
+    uint8_t n = 0;
+    record[n++] = tag;
+    n += putVarint(micros - _lastMicros, &record[n]);
+    _lastMicros = micros;
+    for(uint8_t i=0;i<used;i++){
+        record[n++] = extra[i];
+    }
+    for(uint8_t i=0;i<len;i++){
+        record[n++] = data[i];
+    }
+    size_t written = _out->write(record, n);
+    _bytes += written;
+    return written;
+}
+
+/* Function to record a display frame. Only the bytes that
+ * differ from the previous frame are stored.
+ * @input -> timestamp (micros), frame bytes, length (10 for
+ * a normal frame, anything else is stored raw)
+ * @returns -> bytes written
+ */
+size_t ProjectaTraceWriter::writeFrame(uint32_t micros, const uint8_t* frame, uint8_t length){
+    if(length != 10){
+        length = length < 10 ? length : 10;
+        return emit(PROJ_TRACE_RAW_FRAME | length, micros, frame, length, NULL, 0);
+    }
+    uint16_t mask = 0;
+    uint8_t changed[10];
+    uint8_t n = 0;
+    for(uint8_t i=0;i<10;i++){
+        if(frame[i] != _frame[i]){
+            mask |= 1 << i;
+            changed[n++] = frame[i];
+            _frame[i] = frame[i];
+        }
+    }
+    uint8_t high = (uint8_t)(mask >> 6);
+    return emit(PROJ_TRACE_FRAME | (mask & 0x3F), micros, changed, n, &high, 1);
+}
+
+/* Function to record a button reply
+ * @input -> timestamp (micros), reply bytes, length (3 for a
+ * normal reply, anything else is stored raw)
+ * @returns -> bytes written
+ */
+size_t ProjectaTraceWriter::writeReply(uint32_t micros, const uint8_t* reply, uint8_t length){
+    if(length != 3){
+        length = length < 10 ? length : 10;
+        return emit(PROJ_TRACE_RAW_REPLY | length, micros, reply, length, NULL, 0);
+    }
+    uint8_t mask = 0;
+    uint8_t changed[3];
+    uint8_t n = 0;
+    for(uint8_t i=0;i<3;i++){
+        if(reply[i] != _reply[i]){
+            mask |= 1 << i;
+            changed[n++] = reply[i];
+            _reply[i] = reply[i];
+        }
+    }
+    return emit(PROJ_TRACE_REPLY | mask, micros, changed, n, NULL, 0);
+}
+
+/* Function to record a transfer captured in slave mode
+ * @input -> capture from getCaptures()
+ * @returns -> bytes written
+ */
+size_t ProjectaTraceWriter::writeCapture(const projecta_capture& capture){
+    if(capture.type == CAPTURE_REPLY){
+        return writeReply(capture.micros, capture.data, capture.length);
+    }
+    return writeFrame(capture.micros, capture.data, capture.length);
+}
+
+/* Function to get the size of the trace so far
+ * @input -> NULL
+ * @returns -> bytes written including the header
+ */
+size_t ProjectaTraceWriter::getBytesWritten(){
+    return _bytes;
+}
+
+ProjectaTraceReader::ProjectaTraceReader(const uint8_t* data, size_t length){
+    _data = data;
+    _length = length;
+    _pos = 0;
+    memset(_frame, 0, sizeof(_frame));
+    memset(_reply, 0, sizeof(_reply));
+    _micros = 0;
+    _error = PROJ_OK;
+}
+
+/* Function to check the header and rewind to the first
+ * record
+ * @input -> timestamp given to the start of the trace
+ * @returns -> projecta_error:
+ *      PROJ_OK
+ *      PROJ_TRACE_INVALID (bad magic or unknown version)
+ */
+projecta_error ProjectaTraceReader::begin(uint32_t startMicros){
+    memset(_frame, 0, sizeof(_frame));
+    memset(_reply, 0, sizeof(_reply));
+    _micros = startMicros;
+    _pos = PROJ_TRACE_HEADER_SIZE;
+    if(_length < PROJ_TRACE_HEADER_SIZE || memcmp(_data, _traceMagic, 4) != 0 ||
+        _data[4] != PROJ_TRACE_VERSION){
+        _pos = _length;
+        _error = PROJ_TRACE_INVALID;
+    }else{
+        _error = PROJ_OK;
+    }
+    return _error;
+}
+
+bool ProjectaTraceReader::readVarint(uint32_t& value){
+    value = 0;
+    for(uint8_t shift=0; shift<35; shift+=7){
+        if(_pos >= _length){
+            return false;
+        }
+        uint8_t b = _data[_pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Function to decode the next record
+ * @input -> capture to fill (frames and replies are returned
+ * whole, with the delta applied)
+ * @returns -> false at the end of the trace or on a
+ * truncated record (getError() tells them apart)
+ */
+bool ProjectaTraceReader::next(projecta_capture& capture){
+    if(_pos >= _length){
+        return false;
+    }
+    size_t start = _pos;
+    uint8_t tag = _data[_pos++];
+    uint32_t dt;
+    if(!readVarint(dt)){
+        _pos = start;
+        _error = PROJ_TRACE_INVALID;
+        return false;
+    }
+    uint8_t kind = tag & PROJ_TRACE_KIND_MASK;
+    if(kind == PROJ_TRACE_FRAME){
+        if(_pos >= _length){
+            _pos = start;
+            _error = PROJ_TRACE_INVALID;
+            return false;
+        }
+        uint16_t mask = (tag & 0x3F) | ((uint16_t)_data[_pos++] << 6);
+        for(uint8_t i=0;i<10;i++){
+            if(mask & (1 << i)){
+                if(_pos >= _length){
+                    _pos = start;
+                    _error = PROJ_TRACE_INVALID;
+                    return false;
+                }
+                _frame[i] = _data[_pos++];
+            }
+        }
+        capture.type = CAPTURE_FRAME;
+        capture.length = 10;
+        memcpy(capture.data, _frame, 10);
+    }else if(kind == PROJ_TRACE_REPLY){
+        for(uint8_t i=0;i<3;i++){
+            if(tag & (1 << i)){
+                if(_pos >= _length){
+                    _pos = start;
+                    _error = PROJ_TRACE_INVALID;
+                    return false;
+                }
+                _reply[i] = _data[_pos++];
+            }
+        }
+        capture.type = CAPTURE_REPLY;
+        capture.length = 3;
+        memcpy(capture.data, _reply, 3);
+    }else{
+        uint8_t len = tag & 0x3F;
+        if(len > sizeof(capture.data) || _length - _pos < len){
+            _pos = start;
+            _error = PROJ_TRACE_INVALID;
+            return false;
+        }
+        capture.type = kind == PROJ_TRACE_RAW_REPLY ? CAPTURE_REPLY : CAPTURE_FRAME;
+        capture.length = len;
+        memcpy(capture.data, &_data[_pos], len);
+        _pos += len;
+    }
+    _micros += dt;
+    capture.micros = _micros;
+    return true;
+}
+
+/* Function to get why the last next() returned false
+ * @input -> NULL
+ * @returns -> projecta_error:
+ *      PROJ_OK (end of trace)
+ *      PROJ_TRACE_INVALID (bad header or truncated record)
+ */
+projecta_error ProjectaTraceReader::getError(){
+    return _error;
+}
+
+/* Function to get the read offset, e.g. to report where a
+ * trace is damaged
+ * @input -> NULL
+ * @returns -> offset of the next record
+ */
+size_t ProjectaTraceReader::getPosition(){
+    return _pos;
+}
@@ -0,0 +1,78 @@
+/* Projecta Library - Ben Soutter 2018
+ * Compact append-only trace of bus traffic, for replaying
+ * field captures offline.
+ *
+ * A trace is the 5 byte header "PJTR" + version, followed by
+ * records. Each record starts with a tag byte and the time
+ * since the previous record in microseconds as an unsigned
+ * LEB128 varint:
+ *   0x00 | mask[5:0], varint dt, mask[9:6], changed bytes
+ *        10 byte frame, bytes whose mask bit is set follow
+ *        in order; the rest repeat the previous frame
+ *   0x40 | mask[2:0], varint dt, changed bytes
+ *        3 byte button reply, delta coded the same way
+ *   0x80 | length, varint dt, bytes
+ *        reply of any other length (0-10), stored raw
+ *   0xC0 | length, varint dt, bytes
+ *        frame of any other length (0-10), stored raw
+ * Both ends start from an all-zero frame and reply. An
+ * unchanged frame costs the tag, the mask byte and the time
+ * delta: 4 bytes when frames are under 16.4 ms apart, 5 bytes
+ * from 16.4 ms to 2.1 s (10-20 frames/s is 5).
+ */
+#ifndef ProjectaTrace_h
+#define ProjectaTrace_h
+#include <Projecta.h>
+
+#define PROJ_TRACE_VERSION 1
+#define PROJ_TRACE_HEADER_SIZE 5
+#define PROJ_TRACE_MAX_RECORD 17    // tag + 5 byte varint + mask + 10 bytes
+
+#define PROJ_TRACE_FRAME 0x00
+#define PROJ_TRACE_REPLY 0x40
+#define PROJ_TRACE_RAW_REPLY 0x80
+#define PROJ_TRACE_RAW_FRAME 0xC0
+#define PROJ_TRACE_KIND_MASK 0xC0
+
+/* Writes a trace to any Print: Serial, an SD File or a
+ * flash logger
+ */
+class ProjectaTraceWriter{
+    private:
+        Print* _out;
+        uint8_t _frame[10];
+        uint8_t _reply[3];
+        uint32_t _lastMicros;
+        size_t _bytes;
+        size_t emit(uint8_t tag, uint32_t micros, const uint8_t* data, uint8_t len, const uint8_t* extra, uint8_t used);
+    public:
+        ProjectaTraceWriter(Print& out);
+        size_t begin(uint32_t micros);
+        size_t writeFrame(uint32_t micros, const uint8_t* frame, uint8_t length);
+        size_t writeReply(uint32_t micros, const uint8_t* reply, uint8_t length);
+        size_t writeCapture(const projecta_capture& capture);
+        size_t getBytesWritten();
+};
+
+/* Reads a trace held in memory (e.g. a memory mapped file)
+ * back into projecta_capture records
+ */
+class ProjectaTraceReader{
+    private:
+        const uint8_t* _data;
+        size_t _length;
+        size_t _pos;
+        uint8_t _frame[10];
+        uint8_t _reply[3];
+        uint32_t _micros;
+        projecta_error _error;
+        bool readVarint(uint32_t& value);
+    public:
+        ProjectaTraceReader(const uint8_t* data, size_t length);
+        projecta_error begin(uint32_t startMicros = 0);
+        bool next(projecta_capture& capture);
+        projecta_error getError();
+        size_t getPosition();
+};
+
+#endif